@@ -0,0 +1,143 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Parses captured device and browser requests with HttpParser and compares the
+// runtime-selected DelimiterScanner with its scalar version on the same bytes.
+// Usage: parser_benchmark [iterations]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ioteyeserver.hpp"
+
+namespace {
+struct Capture {
+    const char* name;
+    std::string data;
+};
+
+const std::vector<Capture> kCaptures = {
+    {"device poll",
+     "GET /api/v1/devices/4711/state HTTP/1.1\r\n"
+     "Host: hub.local:8080\r\n"
+     "User-Agent: ESP32HTTPClient\r\n"
+     "Connection: keep-alive\r\n"
+     "\r\n"},
+    {"device telemetry",
+     "POST /api/v1/devices/4711/telemetry HTTP/1.1\r\n"
+     "Host: hub.local:8080\r\n"
+     "User-Agent: ESP32HTTPClient\r\n"
+     "Content-Type: application/json\r\n"
+     "Content-Length: 85\r\n"
+     "Connection: keep-alive\r\n"
+     "\r\n"
+     "{\"ts\":1718000000,\"temperature\":21.5,\"humidity\":40.2,\"battery\":3.71,\"rssi\":-67,\"ok\":1}"},
+    {"browser via proxy",
+     "GET /ui/devices?page=2&sort=name HTTP/1.1\r\n"
+     "Host: hub.example.com\r\n"
+     "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) "
+     "Chrome/124.0.0.0 Safari/537.36\r\n"
+     "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;"
+     "q=0.8,application/signed-exchange;v=b3;q=0.7\r\n"
+     "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+     "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+     "Cache-Control: max-age=0\r\n"
+     "Cookie: session=8f14e45fceea167a5a36dedd4bea2543; theme=dark; _ga=GA1.1.1234567890.1718000000; "
+     "_ga_XYZ=GS1.1.1718000000.3.1.1718000100.0.0.0\r\n"
+     "Referer: https://hub.example.com/ui/devices?page=1&sort=name\r\n"
+     "Sec-Ch-Ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+     "Sec-Ch-Ua-Mobile: ?0\r\n"
+     "Sec-Ch-Ua-Platform: \"Windows\"\r\n"
+     "Sec-Fetch-Dest: document\r\n"
+     "Sec-Fetch-Mode: navigate\r\n"
+     "Sec-Fetch-Site: same-origin\r\n"
+     "Sec-Fetch-User: ?1\r\n"
+     "Upgrade-Insecure-Requests: 1\r\n"
+     "X-Forwarded-For: 203.0.113.7, 198.51.100.12\r\n"
+     "X-Forwarded-Proto: https\r\n"
+     "X-Real-IP: 203.0.113.7\r\n"
+     "Via: 1.1 proxy.example.com\r\n"
+     "Connection: keep-alive\r\n"
+     "\r\n"},
+};
+
+template <typename Function>
+double nanosecondsPer(size_t iterations, Function function) {
+    auto started = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        function();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    return elapsed.count() / iterations;
+}
+
+// Splits data into lines the way the parser does, with the given scan function
+template <typename Scan>
+size_t countLines(const std::string& data, Scan scan) {
+    size_t lines = 0;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        offset += scan(data.data() + offset, data.size() - offset) + 1;
+        ++lines;
+    }
+    return lines;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 500000;
+    std::cout << "scanner: " << ioteye::DelimiterScanner::getImplementationName() << std::endl;
+    ioteye::HttpParser parser;
+    // Warm up caches and CPU frequency before the first measurement
+    for (size_t i = 0; i < iterations; ++i) {
+        parser.parse(kCaptures[0].data.data(), kCaptures[0].data.size());
+        parser.takeRequest();
+    }
+    for (const auto& capture : kCaptures) {
+        size_t failures = 0;
+        double parseCost = nanosecondsPer(iterations, [&]() {
+            parser.parse(capture.data.data(), capture.data.size());
+            failures += !parser.isComplete();
+            parser.takeRequest();
+        });
+        volatile size_t sink = 0;
+        double simdScan = nanosecondsPer(iterations, [&]() {
+            sink += countLines(capture.data, [](const char* data, size_t length) {
+                return ioteye::DelimiterScanner::find(data, length, "\n");
+            });
+        });
+        double scalarScan = nanosecondsPer(iterations, [&]() {
+            sink += countLines(capture.data, [](const char* data, size_t length) {
+                return ioteye::DelimiterScanner::findScalar(data, length, "\n");
+            });
+        });
+        if (failures)
+            std::cerr << capture.name << ": " << failures << " requests failed to parse" << std::endl;
+        std::cout << capture.name << " (" << capture.data.size() << " bytes): parse " << parseCost << " ns, "
+                  << capture.data.size() * 1000.0 / parseCost << " MB/s; line scan " << simdScan << " ns vs scalar "
+                  << scalarScan << " ns" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Measures Router::match for 10, 100 and 1000 routes. Static lookups go through the
+// table made by Router::build() and should cost the same for every route count,
+// parameterized ones walk the radix tree.
+// Usage: router_benchmark [lookups]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ioteyeserver.hpp"
+
+namespace {
+double nanosecondsPerLookup(const ioteye::Router& router, const std::vector<std::string>& uris, size_t lookups) {
+    ioteye::Router::Match match;
+    size_t matched = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+        matched += router.match(uris[i % uris.size()], match);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    if (matched != lookups)
+        std::cerr << "Only " << matched << " of " << lookups << " lookups matched" << std::endl;
+    return elapsed.count() / lookups;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t lookups = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    auto handler = std::make_shared<ioteye::HttpResourceHandler>();
+    std::cout << "routes  static ns/lookup  param ns/lookup" << std::endl;
+    for (size_t routeCount : {10, 100, 1000}) {
+        ioteye::Router router;
+        std::vector<std::string> staticUris;
+        std::vector<std::string> paramUris;
+        for (size_t i = 0; i < routeCount; ++i) {
+            std::string base = "/api/v1/group" + std::to_string(i % 16) + "/device" + std::to_string(i);
+            router.addResource(std::make_shared<ioteye::HttpResource>(handler, base + "/status"));
+            router.addResource(std::make_shared<ioteye::HttpResource>(handler, base + "/sensors/{sensor:alnum}"));
+            staticUris.push_back(base + "/status");
+            paramUris.push_back(base + "/sensors/temp" + std::to_string(i % 4));
+        }
+        router.build();
+        double staticCost = nanosecondsPerLookup(router, staticUris, lookups);
+        double paramCost = nanosecondsPerLookup(router, paramUris, lookups);
+        std::cout << routeCount << "\t" << staticCost << "\t\t" << paramCost << std::endl;
+    }
+    return 0;
+}
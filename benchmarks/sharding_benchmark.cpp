@@ -0,0 +1,122 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Compares requests per second of a single io_context shared by several threads
+// with the sharded mode (one io_context, SO_REUSEPORT acceptor and pinned thread per core).
+// Usage: sharding_benchmark [threads] [clients] [seconds]
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ioteyeserver.hpp"
+
+namespace {
+class PollHandler : public ioteye::HttpResourceHandler {
+public:
+    std::shared_ptr<ioteye::HttpResponse> renderGET(const ioteye::HttpRequest& req) override {
+        (void)req;
+        return std::make_shared<ioteye::HttpResponse>(ioteye::OK, "{\"state\":\"ok\"}");
+    }
+};
+
+// Keeps a persistent connection and sends small GETs until stopped
+void runClient(int port, std::atomic<bool>& running, std::atomic<size_t>& completed) {
+    asio::io_context ioContext;
+    asio::ip::tcp::socket socket(ioContext);
+    asio::error_code error;
+    socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port), error);
+    if (error) {
+        std::cerr << "Client connect failed: " << error.message() << std::endl;
+        return;
+    }
+    socket.set_option(asio::ip::tcp::no_delay(true));
+    const std::string request = "GET /poll HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    asio::streambuf buffer;
+    size_t done = 0;
+    while (running) {
+        asio::write(socket, asio::buffer(request), error);
+        if (error)
+            break;
+        size_t headerLength = asio::read_until(socket, buffer, "\r\n\r\n", error);
+        if (error)
+            break;
+        std::string headers(asio::buffers_begin(buffer.data()),
+                            asio::buffers_begin(buffer.data()) + headerLength);
+        buffer.consume(headerLength);
+        size_t bodyLength = 0;
+        size_t pos = headers.find("Content-Length: ");
+        if (pos != std::string::npos)
+            bodyLength = std::stoul(headers.substr(pos + 16));
+        if (buffer.size() < bodyLength)
+            asio::read(socket, buffer, asio::transfer_exactly(bodyLength - buffer.size()), error);
+        if (error)
+            break;
+        buffer.consume(bodyLength);
+        ++done;
+    }
+    completed += done;
+}
+
+double measure(ioteye::Webserver::Builder builder, int port, size_t clients, int seconds) {
+    ioteye::Webserver server = builder.setTcpPort(port)
+                                   .setMaxRequestsPerConnection(0)
+                                   .setResource("/poll", std::make_shared<PollHandler>())
+                                   .build();
+    server.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::atomic<bool> running{true};
+    std::atomic<size_t> completed{0};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < clients; ++i)
+        threads.emplace_back(runClient, port, std::ref(running), std::ref(completed));
+    auto started = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    running = false;
+    for (auto& thread : threads)
+        thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    server.shutdown();
+    return completed / elapsed.count();
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t threads = argc > 1 ? std::stoul(argv[1]) : std::max(std::thread::hardware_concurrency(), 1u);
+    size_t clients = argc > 2 ? std::stoul(argv[2]) : threads * 4;
+    int seconds = argc > 3 ? std::stoi(argv[3]) : 5;
+    std::cout << "threads: " << threads << ", clients: " << clients << ", seconds: " << seconds
+              << std::endl;
+
+    double shared = measure(ioteye::Webserver::Builder().setThreadCount(threads), 9180, clients, seconds);
+    std::cout << "shared io_context: " << static_cast<size_t>(shared) << " req/s" << std::endl;
+
+    double sharded = measure(ioteye::Webserver::Builder().setShardCount(threads), 9181, clients, seconds);
+    std::cout << "sharded:           " << static_cast<size_t>(sharded) << " req/s" << std::endl;
+    std::cout << "speedup:           " << sharded / shared << "x" << std::endl;
+    return 0;
+}
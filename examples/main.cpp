@@ -24,36 +24,25 @@ SOFTWARE.
 
 #include <iostream>
 #include <memory>
+#include <optional>
 
 #include "ioteyeserver.hpp"
 
-bool canConvertToInt(const std::string& str) {
-    try {
-        std::stoi(str);
-        return true;
-    } catch (const std::invalid_argument&) {
-        return false;
-    } catch (const std::out_of_range&) {
-        return false;
-    }
-}
-
 // Create a simple echo handler
 class EchoHandler : public ioteye::HttpResourceHandler {
 public:
     std::shared_ptr<ioteye::HttpResponse> renderGET(const ioteye::HttpRequest& req) override {
         auto response = std::make_shared<ioteye::HttpResponse>();
         response->setStatusCode(200);
-        std::string p1Str = req.getArg("param1");
-        std::string p2Str = req.getArg("param2");
-        int p1 = 0, p2 = 0;
+        std::string p1Str(req.getArg("param1"));
+        std::string p2Str(req.getArg("param2"));
+        std::optional<int> p1 = req.getArg<int>("param1");
+        std::optional<int> p2 = req.getArg<int>("param2");
 
-        response->setBody("You requested: " + req.getUri() + "\n");
+        response->setBody("You requested: " + std::string(req.getUri()) + "\n");
         if (!p1Str.empty() && !p2Str.empty()) {
-            if (canConvertToInt(p1Str) && canConvertToInt(p2Str)) {
-                p1 = stoi(p1Str);
-                p2 = stoi(p2Str);
-                response->addBody("Summ: " + std::to_string(p1 + p2) + "\n");
+            if (p1 && p2) {
+                response->addBody("Summ: " + std::to_string(*p1 + *p2) + "\n");
             } else
                 response->addBody("Cant sum " + p1Str + " and " + p2Str + '\n');
         }
@@ -64,23 +53,23 @@ public:
     std::shared_ptr<ioteye::HttpResponse> renderPOST(const ioteye::HttpRequest& req) override {
         auto response = std::make_shared<ioteye::HttpResponse>();
         response->setStatusCode(200);
-        response->setBody("You sent a POST request to: " + req.getUri() + "\n" +
-                          "With Body: " + req.getBody());
+        response->setBody("You sent a POST request to: " + std::string(req.getUri()) + "\n" +
+                          "With Body: " + std::string(req.getBody()));
         response->setHeader("Content-Type", "text/plain");
         return response;
     }
     std::shared_ptr<ioteye::HttpResponse> renderPUT(const ioteye::HttpRequest& req) override {
         auto response = std::make_shared<ioteye::HttpResponse>();
         response->setStatusCode(200);
-        response->setBody("You sent a PUT request to: " + req.getUri() + "\n" +
-                          "With Body: " + req.getBody());
+        response->setBody("You sent a PUT request to: " + std::string(req.getUri()) + "\n" +
+                          "With Body: " + std::string(req.getBody()));
         response->setHeader("Content-Type", "text/plain");
         return response;
     }
     std::shared_ptr<ioteye::HttpResponse> renderDELETE(const ioteye::HttpRequest& req) override {
         auto response = std::make_shared<ioteye::HttpResponse>();
         response->setStatusCode(200);
-        response->setBody("You sent a DELETE request to: " + req.getUri());
+        response->setBody("You sent a DELETE request to: " + std::string(req.getUri()));
         response->setHeader("Content-Type", "text/plain");
         return response;
     }
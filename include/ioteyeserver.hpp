@@ -35,9 +35,22 @@ SOFTWARE.
  */
 
 #include "ioteyeserver/httpserver/webserver.hpp"
+#include "ioteyeserver/httpserver/body_consumer.hpp"
+#include "ioteyeserver/httpserver/buffer_pool.hpp"
+#include "ioteyeserver/httpserver/byte_range.hpp"
+#include "ioteyeserver/httpserver/compression.hpp"
+#include "ioteyeserver/httpserver/delimiter_scanner.hpp"
+#include "ioteyeserver/httpserver/file_body.hpp"
+#include "ioteyeserver/httpserver/http_date.hpp"
+#include "ioteyeserver/httpserver/http_parser.hpp"
 #include "ioteyeserver/httpserver/http_request.hpp"
 #include "ioteyeserver/httpserver/http_response.hpp"
 #include "ioteyeserver/httpserver/http_resource.hpp"
+#include "ioteyeserver/httpserver/response_cache.hpp"
+#include "ioteyeserver/httpserver/router.hpp"
+#include "ioteyeserver/httpserver/static_files.hpp"
+#include "ioteyeserver/httpserver/tcp_connection.hpp"
+#include "ioteyeserver/small_vector.hpp"
 #include "ioteyeserver/utils.hpp"
 #include "ioteyeserver/types.hpp"
 #include "ioteyeserver/http_status_codes.hpp"
@@ -25,8 +25,10 @@ SOFTWARE.
 #ifndef IOTEYE_HTTP_STATUS_CODES_HPP
 #define IOTEYE_HTTP_STATUS_CODES_HPP
 
+#include <array>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace ioteye {
 
@@ -108,85 +110,113 @@ enum HttpStatusCode {
 }  // namespace ioteye
 
 namespace ioteye::util {
+namespace detail {
+struct StatusLine {
+    uint16_t code;
+    std::string_view line;
+};
+
+// Pre-serialized status lines, the reason phrase is what follows the code
+constexpr StatusLine kStatusLineList[] = {
+    // Informational 1xx
+    {CONTINUE, "HTTP/1.1 100 Continue\r\n"},
+    {SWITCHING_PROTOCOLS, "HTTP/1.1 101 Switching Protocols\r\n"},
+    {PROCESSING, "HTTP/1.1 102 Processing\r\n"},
+    {EARLY_HINTS, "HTTP/1.1 103 Early Hints\r\n"},
+
+    // Successful 2xx
+    {OK, "HTTP/1.1 200 OK\r\n"},
+    {CREATED, "HTTP/1.1 201 Created\r\n"},
+    {ACCEPTED, "HTTP/1.1 202 Accepted\r\n"},
+    {NON_AUTHORITATIVE_INFORMATION, "HTTP/1.1 203 Non-Authoritative Information\r\n"},
+    {NO_CONTENT, "HTTP/1.1 204 No Content\r\n"},
+    {RESET_CONTENT, "HTTP/1.1 205 Reset Content\r\n"},
+    {PARTIAL_CONTENT, "HTTP/1.1 206 Partial Content\r\n"},
+    {MULTI_STATUS, "HTTP/1.1 207 Multi-Status\r\n"},
+    {ALREADY_REPORTED, "HTTP/1.1 208 Already Reported\r\n"},
+    {IM_USED, "HTTP/1.1 226 IM Used\r\n"},
+
+    // Redirection 3xx
+    {MULTIPLE_CHOICES, "HTTP/1.1 300 Multiple Choices\r\n"},
+    {MOVED_PERMANENTLY, "HTTP/1.1 301 Moved Permanently\r\n"},
+    {FOUND, "HTTP/1.1 302 Found\r\n"},
+    {SEE_OTHER, "HTTP/1.1 303 See Other\r\n"},
+    {NOT_MODIFIED, "HTTP/1.1 304 Not Modified\r\n"},
+    {USE_PROXY, "HTTP/1.1 305 Use Proxy\r\n"},
+    {TEMPORARY_REDIRECT, "HTTP/1.1 307 Temporary Redirect\r\n"},
+    {PERMANENT_REDIRECT, "HTTP/1.1 308 Permanent Redirect\r\n"},
+
+    // Client Error 4xx
+    {BAD_REQUEST, "HTTP/1.1 400 Bad Request\r\n"},
+    {UNAUTHORIZED, "HTTP/1.1 401 Unauthorized\r\n"},
+    {PAYMENT_REQUIRED, "HTTP/1.1 402 Payment Required\r\n"},
+    {FORBIDDEN, "HTTP/1.1 403 Forbidden\r\n"},
+    {NOT_FOUND, "HTTP/1.1 404 Not Found\r\n"},
+    {METHOD_NOT_ALLOWED, "HTTP/1.1 405 Method Not Allowed\r\n"},
+    {NOT_ACCEPTABLE, "HTTP/1.1 406 Not Acceptable\r\n"},
+    {PROXY_AUTHENTICATION_REQUIRED, "HTTP/1.1 407 Proxy Authentication Required\r\n"},
+    {REQUEST_TIMEOUT, "HTTP/1.1 408 Request Timeout\r\n"},
+    {CONFLICT, "HTTP/1.1 409 Conflict\r\n"},
+    {GONE, "HTTP/1.1 410 Gone\r\n"},
+    {LENGTH_REQUIRED, "HTTP/1.1 411 Length Required\r\n"},
+    {PRECONDITION_FAILED, "HTTP/1.1 412 Precondition Failed\r\n"},
+    {PAYLOAD_TOO_LARGE, "HTTP/1.1 413 Payload Too Large\r\n"},
+    {URI_TOO_LONG, "HTTP/1.1 414 URI Too Long\r\n"},
+    {UNSUPPORTED_MEDIA_TYPE, "HTTP/1.1 415 Unsupported Media Type\r\n"},
+    {RANGE_NOT_SATISFIABLE, "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+    {EXPECTATION_FAILED, "HTTP/1.1 417 Expectation Failed\r\n"},
+    {IM_A_TEAPOT, "HTTP/1.1 418 I'm a teapot\r\n"},
+    {MISDIRECTED_REQUEST, "HTTP/1.1 421 Misdirected Request\r\n"},
+    {UNPROCESSABLE_ENTITY, "HTTP/1.1 422 Unprocessable Entity\r\n"},
+    {LOCKED, "HTTP/1.1 423 Locked\r\n"},
+    {FAILED_DEPENDENCY, "HTTP/1.1 424 Failed Dependency\r\n"},
+    {TOO_EARLY, "HTTP/1.1 425 Too Early\r\n"},
+    {UPGRADE_REQUIRED, "HTTP/1.1 426 Upgrade Required\r\n"},
+    {PRECONDITION_REQUIRED, "HTTP/1.1 428 Precondition Required\r\n"},
+    {TOO_MANY_REQUESTS, "HTTP/1.1 429 Too Many Requests\r\n"},
+    {REQUEST_HEADER_FIELDS_TOO_LARGE, "HTTP/1.1 431 Request Header Fields Too Large\r\n"},
+    {UNAVAILABLE_FOR_LEGAL_REASONS, "HTTP/1.1 451 Unavailable For Legal Reasons\r\n"},
+
+    // Server Error 5xx
+    {INTERNAL_SERVER_ERROR, "HTTP/1.1 500 Internal Server Error\r\n"},
+    {NOT_IMPLEMENTED, "HTTP/1.1 501 Not Implemented\r\n"},
+    {BAD_GATEWAY, "HTTP/1.1 502 Bad Gateway\r\n"},
+    {SERVICE_UNAVAILABLE, "HTTP/1.1 503 Service Unavailable\r\n"},
+    {GATEWAY_TIMEOUT, "HTTP/1.1 504 Gateway Timeout\r\n"},
+    {HTTP_VERSION_NOT_SUPPORTED, "HTTP/1.1 505 HTTP Version Not Supported\r\n"},
+    {VARIANT_ALSO_NEGOTIATES, "HTTP/1.1 506 Variant Also Negotiates\r\n"},
+    {INSUFFICIENT_STORAGE, "HTTP/1.1 507 Insufficient Storage\r\n"},
+    {LOOP_DETECTED, "HTTP/1.1 508 Loop Detected\r\n"},
+    {NOT_EXTENDED, "HTTP/1.1 510 Not Extended\r\n"},
+    {NETWORK_AUTHENTICATION_REQUIRED, "HTTP/1.1 511 Network Authentication Required\r\n"},
+};
+
+constexpr uint16_t kMinStatusCode = 100;
+constexpr uint16_t kMaxStatusCode = 599;
+
+constexpr std::array<std::string_view, kMaxStatusCode - kMinStatusCode + 1> makeStatusLines() {
+    std::array<std::string_view, kMaxStatusCode - kMinStatusCode + 1> lines{};
+    for (const auto& status : kStatusLineList)
+        lines[status.code - kMinStatusCode] = status.line;
+    return lines;
+}
+
+inline constexpr auto kStatusLines = makeStatusLines();
+}  // namespace detail
+
+// "HTTP/1.1 200 OK\r\n", empty for unknown codes
+constexpr std::string_view getStatusLine(int statusCode) {
+    if (statusCode < detail::kMinStatusCode || statusCode > detail::kMaxStatusCode)
+        return {};
+    return detail::kStatusLines[statusCode - detail::kMinStatusCode];
+}
+
 inline std::string getStatusMessage(uint16_t statusCode) {
-    static const std::unordered_map<uint16_t, std::string> statusMessages = {
-        // Informational 1xx
-        {CONTINUE, "Continue"},
-        {SWITCHING_PROTOCOLS, "Switching Protocols"},
-        {PROCESSING, "Processing"},
-        {EARLY_HINTS, "Early Hints"},
-
-        // Successful 2xx
-        {OK, "OK"},
-        {CREATED, "Created"},
-        {ACCEPTED, "Accepted"},
-        {NON_AUTHORITATIVE_INFORMATION, "Non-Authoritative Information"},
-        {NO_CONTENT, "No Content"},
-        {RESET_CONTENT, "Reset Content"},
-        {PARTIAL_CONTENT, "Partial Content"},
-        {MULTI_STATUS, "Multi-Status"},
-        {ALREADY_REPORTED, "Already Reported"},
-        {IM_USED, "IM Used"},
-
-        // Redirection 3xx
-        {MULTIPLE_CHOICES, "Multiple Choices"},
-        {MOVED_PERMANENTLY, "Moved Permanently"},
-        {FOUND, "Found"},
-        {SEE_OTHER, "See Other"},
-        {NOT_MODIFIED, "Not Modified"},
-        {USE_PROXY, "Use Proxy"},
-        {TEMPORARY_REDIRECT, "Temporary Redirect"},
-        {PERMANENT_REDIRECT, "Permanent Redirect"},
-
-        // Client Error 4xx
-        {BAD_REQUEST, "Bad Request"},
-        {UNAUTHORIZED, "Unauthorized"},
-        {PAYMENT_REQUIRED, "Payment Required"},
-        {FORBIDDEN, "Forbidden"},
-        {NOT_FOUND, "Not Found"},
-        {METHOD_NOT_ALLOWED, "Method Not Allowed"},
-        {NOT_ACCEPTABLE, "Not Acceptable"},
-        {PROXY_AUTHENTICATION_REQUIRED, "Proxy Authentication Required"},
-        {REQUEST_TIMEOUT, "Request Timeout"},
-        {CONFLICT, "Conflict"},
-        {GONE, "Gone"},
-        {LENGTH_REQUIRED, "Length Required"},
-        {PRECONDITION_FAILED, "Precondition Failed"},
-        {PAYLOAD_TOO_LARGE, "Payload Too Large"},
-        {URI_TOO_LONG, "URI Too Long"},
-        {UNSUPPORTED_MEDIA_TYPE, "Unsupported Media Type"},
-        {RANGE_NOT_SATISFIABLE, "Range Not Satisfiable"},
-        {EXPECTATION_FAILED, "Expectation Failed"},
-        {IM_A_TEAPOT, "I'm a teapot"},
-        {MISDIRECTED_REQUEST, "Misdirected Request"},
-        {UNPROCESSABLE_ENTITY, "Unprocessable Entity"},
-        {LOCKED, "Locked"},
-        {FAILED_DEPENDENCY, "Failed Dependency"},
-        {TOO_EARLY, "Too Early"},
-        {UPGRADE_REQUIRED, "Upgrade Required"},
-        {PRECONDITION_REQUIRED, "Precondition Required"},
-        {TOO_MANY_REQUESTS, "Too Many Requests"},
-        {REQUEST_HEADER_FIELDS_TOO_LARGE, "Request Header Fields Too Large"},
-        {UNAVAILABLE_FOR_LEGAL_REASONS, "Unavailable For Legal Reasons"},
-
-        // Server Error 5xx
-        {INTERNAL_SERVER_ERROR, "Internal Server Error"},
-        {NOT_IMPLEMENTED, "Not Implemented"},
-        {BAD_GATEWAY, "Bad Gateway"},
-        {SERVICE_UNAVAILABLE, "Service Unavailable"},
-        {GATEWAY_TIMEOUT, "Gateway Timeout"},
-        {HTTP_VERSION_NOT_SUPPORTED, "HTTP Version Not Supported"},
-        {VARIANT_ALSO_NEGOTIATES, "Variant Also Negotiates"},
-        {INSUFFICIENT_STORAGE, "Insufficient Storage"},
-        {LOOP_DETECTED, "Loop Detected"},
-        {NOT_EXTENDED, "Not Extended"},
-        {NETWORK_AUTHENTICATION_REQUIRED, "Network Authentication Required"}};
-
-    auto it = statusMessages.find(statusCode);
-    if (it != statusMessages.end()) {
-        return it->second;
-    }
-    return "Unknown Status";
+    std::string_view line = getStatusLine(statusCode);
+    if (line.empty())
+        return "Unknown Status";
+    // Skip "HTTP/1.1 NNN " and the trailing CRLF
+    return std::string(line.substr(13, line.size() - 15));
 }
 }  // namespace ioteye::util
 
@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_BODY_CONSUMER_HPP
+#define IOTEYE_BODY_CONSUMER_HPP
+
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "ioteyeserver/httpserver/http_request.hpp"
+#include "ioteyeserver/httpserver/http_response.hpp"
+
+namespace ioteye {
+// Receives a request body piece by piece while it is read, see
+// HttpResourceHandler::consumeBody(). Calls come from the connection's strand, one at a time
+class BodyConsumer {
+public:
+    virtual ~BodyConsumer() = default;
+
+    // Next piece of the body with any chunked encoding removed. The view is valid only during
+    // the call. Returning false pauses reading until resume() is called
+    virtual bool onData(std::string_view data) = 0;
+    // Whole body is received, the response answers the request
+    virtual std::shared_ptr<HttpResponse> onEnd(const HttpRequest& req) = 0;
+    // Body will never be complete: the client went away or sent a malformed body
+    virtual void onAbort() {
+    }
+
+    // Continues reading after onData() returned false. Can be called from any thread
+    void resume() {
+        if (m_resume)
+            m_resume();
+    }
+
+private:
+    friend class TcpConnection;
+
+    std::function<void()> m_resume;
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_BODY_CONSUMER_HPP
@@ -0,0 +1,107 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_BUFFER_POOL_HPP
+#define IOTEYE_BUFFER_POOL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ioteye {
+
+// Fixed-size I/O buffers preallocated in one slab. Free buffers are kept in a lock-free
+// stack, so leasing and returning them from several io_context threads needs no mutex.
+// When the slab is exhausted buffers are allocated on the heap and counted as misses.
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t inUse = 0;
+    };
+
+    // Buffer returned to the pool on destruction
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        char* data() const {
+            return m_data;
+        }
+        size_t size() const {
+            return m_size;
+        }
+        explicit operator bool() const {
+            return m_data != nullptr;
+        }
+        void release();
+
+    private:
+        friend class BufferPool;
+        Lease(std::shared_ptr<BufferPool> pool, char* data, size_t size, uint32_t slot);
+
+        std::shared_ptr<BufferPool> m_pool;
+        char* m_data = nullptr;
+        size_t m_size = 0;
+        uint32_t m_slot = 0;  // 0 for heap allocated buffers
+    };
+
+    BufferPool(size_t bufferSize, size_t capacity);
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    Lease acquire();
+
+    size_t getBufferSize() const {
+        return m_bufferSize;
+    }
+    size_t getCapacity() const {
+        return m_capacity;
+    }
+    Stats getStats() const;
+
+private:
+    void giveBack(char* data, uint32_t slot);
+
+private:
+    size_t m_bufferSize;
+    size_t m_capacity;
+    std::unique_ptr<char[]> m_slab;
+    // Free list links, slot numbers start from 1 so 0 marks the end of the list
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+    // Top slot in the low half and modification counter in the high half against ABA
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_misses{0};
+    std::atomic<size_t> m_inUse{0};
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_BUFFER_POOL_HPP
@@ -0,0 +1,56 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_BYTE_RANGE_HPP
+#define IOTEYE_BYTE_RANGE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "ioteyeserver/httpserver/http_request.hpp"
+#include "ioteyeserver/httpserver/http_response.hpp"
+
+namespace ioteye {
+struct ByteRange {
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+namespace util {
+enum class RangeStatus { IGNORED, SATISFIABLE, UNSATISFIABLE };
+
+// Range header against a body of size bytes (RFC 9110, 14.2). Only a single range is served,
+// lists of ranges and malformed values are IGNORED and get the whole body
+RangeStatus parseRange(std::string_view range, uint64_t size, ByteRange& byteRange);
+// If-Range holds either a strong ETag or the exact Last-Modified date (RFC 9110, 13.1.5)
+bool ifRangeMatches(std::string_view ifRange, std::string_view etag, std::string_view lastModified);
+}  // namespace util
+
+// 206 Partial Content or 416 answer to a GET with a Range header. Only complete 200 answers
+// which advertise Accept-Ranges: bytes are split, anything else is returned as is
+std::shared_ptr<HttpResponse> applyRange(const HttpRequest& request, std::shared_ptr<HttpResponse> response);
+}  // namespace ioteye
+
+#endif  // IOTEYE_BYTE_RANGE_HPP
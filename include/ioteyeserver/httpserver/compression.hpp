@@ -0,0 +1,88 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_COMPRESSION_HPP
+#define IOTEYE_COMPRESSION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "ioteyeserver/httpserver/http_request.hpp"
+#include "ioteyeserver/httpserver/http_response.hpp"
+#include "ioteyeserver/types.hpp"
+
+namespace ioteye {
+struct CompressionConfig {
+    bool enabled = true;
+    // Smaller bodies are sent as is, compressing them saves less than it costs
+    size_t minSize = 1024;
+    // zlib level, 1 is the fastest and 9 the smallest
+    int level = 6;
+};
+
+struct CompressionStats {
+    // Responses sent compressed, including those served from precompressed variants
+    size_t responses = 0;
+    // Times a body was actually compressed
+    size_t compressions = 0;
+    // Body sizes of the compressed responses before and after compression
+    size_t bytesIn = 0;
+    size_t bytesOut = 0;
+    std::chrono::nanoseconds compressTime{0};
+};
+
+namespace util {
+// Coding the client prefers among the supported ones, IDENTITY when none is acceptable
+ContentEncoding negotiateContentEncoding(std::string_view acceptEncoding);
+std::string_view contentEncodingName(ContentEncoding encoding);
+// Text formats, JSON and XML. Images, archives and unknown binary types are already dense
+bool isCompressibleType(std::string_view contentType);
+// gzip or zlib stream of the data, empty when zlib fails
+std::string compress(std::string_view data, ContentEncoding encoding, int level);
+}  // namespace util
+
+// Compresses response bodies for clients which accept it. Canned responses keep their
+// compressed copies, so constant and cached answers are compressed once per encoding
+class ResponseCompressor {
+public:
+    std::shared_ptr<HttpResponse> compress(const HttpRequest& request, const CompressionConfig& config,
+                                           std::shared_ptr<HttpResponse> response);
+    CompressionStats getStats() const;
+
+private:
+    std::shared_ptr<HttpResponse> served(std::shared_ptr<HttpResponse> response, size_t bytesIn);
+
+    std::atomic<size_t> m_responses{0};
+    std::atomic<size_t> m_compressions{0};
+    std::atomic<size_t> m_bytesIn{0};
+    std::atomic<size_t> m_bytesOut{0};
+    std::atomic<int64_t> m_compressNanoseconds{0};
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_COMPRESSION_HPP
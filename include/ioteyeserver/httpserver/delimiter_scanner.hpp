@@ -0,0 +1,57 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_DELIMITER_SCANNER_HPP
+#define IOTEYE_DELIMITER_SCANNER_HPP
+
+#include <cstddef>
+#include <string_view>
+
+namespace ioteye {
+
+// Finds the first byte which is one of up to four delimiters or a control character
+// (below 0x20 except tab, or DEL), so one pass both locates a delimiter and checks
+// the bytes before it. Uses AVX2 or SSE2 when the CPU has them, chosen at runtime,
+// and plain loops elsewhere.
+class DelimiterScanner {
+public:
+    static constexpr size_t kMaxDelimiters = 4;
+
+    // Offset of the stop byte, length when there is none
+    static size_t find(const char* data, size_t length, std::string_view delimiters);
+    static size_t findScalar(const char* data, size_t length, std::string_view delimiters);
+    // "avx2", "sse2" or "scalar"
+    static const char* getImplementationName();
+
+    static bool isControl(unsigned char c) {
+        return (c < 0x20 && c != '\t') || c == 0x7f;
+    }
+    // tchar of RFC 9110, 5.6.2, allowed in methods and header names
+    static bool isTokenChar(unsigned char c);
+    // Length of the token prefix of data
+    static size_t findTokenEnd(const char* data, size_t length);
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_DELIMITER_SCANNER_HPP
@@ -0,0 +1,82 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_FILE_BODY_HPP
+#define IOTEYE_FILE_BODY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <fstream>
+#include <mutex>
+#endif
+
+namespace ioteye {
+
+// Open file a response body is sent from. Nothing is read into memory: connections send it
+// with sendfile(2) where available and in chunks of bounded size elsewhere
+class FileBody {
+public:
+    // nullptr when the file can't be opened or isn't a regular file
+    static std::shared_ptr<FileBody> open(const std::string& path);
+
+    FileBody(const FileBody&) = delete;
+    FileBody& operator=(const FileBody&) = delete;
+    ~FileBody();
+
+#ifndef _WIN32
+    int getDescriptor() const {
+        return m_fd;
+    }
+#endif
+    // Size and modification time when the file was opened
+    uint64_t getSize() const {
+        return m_size;
+    }
+    std::time_t getModified() const {
+        return m_modified;
+    }
+    // Up to length bytes from offset, fewer at the end of the file. -1 on error
+    long long read(uint64_t offset, char* out, size_t length) const;
+
+private:
+    FileBody(uint64_t size, std::time_t modified);
+
+#ifdef _WIN32
+    // Reads seek the shared stream, so they take turns
+    mutable std::mutex m_mutex;
+    mutable std::ifstream m_stream;
+#else
+    int m_fd = -1;
+#endif
+    uint64_t m_size;
+    std::time_t m_modified;
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_FILE_BODY_HPP
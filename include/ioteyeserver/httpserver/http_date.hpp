@@ -0,0 +1,51 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_HTTP_DATE_HPP
+#define IOTEYE_HTTP_DATE_HPP
+
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace ioteye {
+
+// Value of the Date header (RFC 9110, 5.6.7). A running server ticks the clock once a second
+// from a timer, so responses only copy text which was formatted for that second. Without
+// ticks the system clock is read directly.
+class HttpDate {
+public:
+    // "Sun, 06 Nov 1994 08:49:37 GMT". The view is valid until the next call on this thread
+    static std::string_view now();
+    static std::string format(std::time_t time);
+    // Second now() is formatted for
+    static std::time_t currentTime();
+
+    static void tick();
+    // Server no longer ticks, now() goes back to reading the clock
+    static void stopTicking();
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_HTTP_DATE_HPP
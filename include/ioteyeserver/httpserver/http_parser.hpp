@@ -0,0 +1,119 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_HTTP_PARSER_HPP
+#define IOTEYE_HTTP_PARSER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "ioteyeserver/http_status_codes.hpp"
+#include "ioteyeserver/httpserver/http_request.hpp"
+
+namespace ioteye {
+
+// Incremental HTTP/1.x request parser. Bytes can be fed in arbitrary pieces as they
+// arrive from the socket; parsing stops right after a complete request so that
+// bytes of the following one are left to the caller. A request which arrived in one
+// piece views the caller's bytes, the ones split between pieces are copied. Chunked
+// bodies are decoded, trailer fields are dropped.
+class HttpParser {
+public:
+    enum class ParseState { REQUEST_LINE, HEADERS, BODY, COMPLETE, FAILED };
+    // Gets each piece of a body, returning false stops parse() right after the piece
+    using BodyConsumer = std::function<bool(std::string_view data)>;
+
+    explicit HttpParser(size_t maxHeaderSize = 8192, size_t maxBodySize = 1024 * 1024);
+
+    // Returns number of bytes consumed from data
+    size_t parse(const char* data, size_t length);
+    void reset();
+
+    ParseState getState() const {
+        return m_state;
+    }
+    bool isComplete() const {
+        return m_state == ParseState::COMPLETE;
+    }
+    bool hasError() const {
+        return m_state == ParseState::FAILED;
+    }
+    // Has some bytes of a request been consumed already
+    bool isStarted() const {
+        return m_state != ParseState::REQUEST_LINE || !m_pendingLine.empty();
+    }
+    HttpStatusCode getErrorStatus() const {
+        return m_errorStatus;
+    }
+    // Moves the parsed request out and prepares parser for the next one. The request may
+    // view the bytes of the last parse() call
+    HttpRequest takeRequest();
+    // Called once the head of a request with a body is parsed, before the body. It may set
+    // a body consumer for that request
+    void setHeadCallback(std::function<void(HttpRequest& request)> callback);
+    // Body of the current request goes to consumer instead of the request, maxBodySize
+    // doesn't apply then
+    void setBodyConsumer(BodyConsumer consumer);
+
+private:
+    enum class ChunkState { SIZE, DATA, DATA_END, TRAILER };
+
+    size_t parseBody(const char* data, size_t length);
+    size_t parseChunked(const char* data, size_t length);
+    bool handleChunkLine(std::string_view line);
+    size_t parseLines(const char* data, size_t length);
+    bool handleLine(std::string_view line);
+    bool parseRequestLine(std::string_view line);
+    bool parseHeaderLine(std::string_view line);
+    bool finishHeaders();
+    void fail(HttpStatusCode status);
+
+private:
+    ParseState m_state = ParseState::REQUEST_LINE;
+    HttpStatusCode m_errorStatus = HttpStatusCode::BAD_REQUEST;
+    size_t m_maxHeaderSize;
+    size_t m_maxBodySize;
+    size_t m_headerSize = 0;
+    size_t m_contentLength = 0;
+    bool m_hasContentLength = false;
+    size_t m_bodyReceived = 0;
+    bool m_isChunked = false;
+    ChunkState m_chunkState = ChunkState::SIZE;
+    uint64_t m_chunkRemaining = 0;
+    std::function<void(HttpRequest& request)> m_headCallback;
+    BodyConsumer m_bodyConsumer;
+    // The consumer asked to stop during the current parse() call
+    bool m_isPaused = false;
+    std::string m_pendingLine;
+    // m_request views bytes passed to the current parse() call
+    bool m_hasBorrowedViews = false;
+    HttpRequest m_request;
+    // Body which arrived in several pieces
+    std::string m_body;
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_HTTP_PARSER_HPP
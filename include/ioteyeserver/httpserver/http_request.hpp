@@ -25,42 +25,126 @@ SOFTWARE.
 #ifndef IOTEYE_HTTP_REQUEST_HPP
 #define IOTEYE_HTTP_REQUEST_HPP
 
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "ioteyeserver/types.hpp"
 
 namespace ioteye {
+// Request as a set of views. Requests coming from the parser point into the connection read
+// buffer and stay valid only for the duration of the handler call; call materialize() to
+// keep the request longer. Setters store views as well, the viewed data has to outlive the
+// request or be materialized.
 class HttpRequest {
 public:
+    using Args = std::vector<std::pair<std::string_view, std::string_view>>;
+
     HttpRequest() = default;
 
-    std::string getArg(const std::string& arg_name) const;
-    void setArg(const std::string& argName, const std::string& argValue) {
-        m_args[argName] = argValue;
+    // Empty when the argument is missing
+    std::string_view getArg(std::string_view argName) const;
+    // Argument converted to an integer type, empty when missing or not a number of that type
+    template <typename T>
+    std::optional<T> getArg(std::string_view argName) const {
+        const std::string_view* value = findArg(argName);
+        return value ? toNumber<T>(*value) : std::nullopt;
     }
+    void setArg(std::string_view argName, std::string_view argValue);
     void clearArgs();
 
+    // Query string parameters, percent-decoded on first access. First of repeated names wins,
+    // empty when the parameter is missing. Decoding fills a cache, so a request must not be
+    // read from several threads at once
+    std::string_view getQueryParam(std::string_view name) const;
+    template <typename T>
+    std::optional<T> getQueryParam(std::string_view name) const {
+        const std::string_view* value = findQueryParam(name);
+        return value ? toNumber<T>(*value) : std::nullopt;
+    }
+    bool hasQueryParam(std::string_view name) const;
+    const Args& getQueryParams() const;
+
     // Getters
     HttpMethod getMethod() const;
-    const std::string& getUri() const;
-    const std::unordered_map<std::string, std::string>& getArgs() const;
-    const std::string& getHeaders() const;
-    const std::string& getBody() const;
+    // Path part of the request target, routes are matched against it
+    std::string_view getUri() const;
+    // Raw query string without the '?'
+    std::string_view getQuery() const;
+    std::string_view getVersion() const;
+    const Args& getArgs() const;
+    // Header lines rebuilt from the index as "name: value" separated by CRLF
+    std::string getHeaders() const;
+    // Case-insensitive, first of repeated headers wins. Empty when the header is missing
+    std::string_view getHeader(std::string_view name) const;
+    bool hasHeader(std::string_view name) const;
+    std::string_view getBody() const;
 
     // Setters
     void setMethod(HttpMethod method);
-    void setUri(const std::string& uri);
-    void setArgs(const std::unordered_map<std::string, std::string>& args);
-    void setHeaders(const std::string& headers);
-    void setBody(const std::string& body);
+    void setUri(std::string_view uri);
+    void setQuery(std::string_view query);
+    void setVersion(std::string_view version);
+    void setArgs(Args args);
+    // Raw header lines separated by CRLF, indexed on the way in
+    void setHeaders(std::string_view headers);
+    void addHeader(std::string_view name, std::string_view value);
+    void setBody(std::string_view body);
+    // Takes ownership of a body which was collected outside of the read buffer
+    void adoptBody(std::string body);
+
+    // Copies everything the request views into storage of its own, copies of the request
+    // share that storage
+    void materialize();
 
 private:
+    // Hash is of the lowercase name
+    struct HeaderField {
+        std::string_view name;
+        std::string_view value;
+        uint32_t nameHash;
+    };
+    // Headers the server itself asks for get a direct slot in m_knownHeaders
+    static constexpr size_t kKnownHeaderCount = 9;
+
+    template <typename T>
+    static std::optional<T> toNumber(std::string_view value) {
+        static_assert(std::is_integral_v<T>, "only integer types are supported");
+        T number;
+        auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+        if (ec != std::errc() || ptr != value.data() + value.size())
+            return std::nullopt;
+        return number;
+    }
+
+    const std::string_view* findArg(std::string_view argName) const;
+    const std::string_view* findQueryParam(std::string_view name) const;
+    void parseQuery() const;
+    const HeaderField* findHeader(std::string_view name) const;
+
     HttpMethod m_method = HttpMethod::HTTP_METHOD_MAX;
-    std::string m_uri;
-    std::unordered_map<std::string, std::string> m_args;
-    std::string m_headers;
-    std::string m_body;
+    std::string_view m_uri;
+    std::string_view m_query;
+    // Filled from m_query on first access, decoded parts live in m_queryStorage
+    mutable Args m_queryParams;
+    mutable bool m_isQueryParsed = false;
+    mutable std::shared_ptr<const std::string> m_queryStorage;
+    std::string_view m_version;
+    Args m_args;
+    std::vector<HeaderField> m_headerFields;
+    // Index into m_headerFields plus one, 0 when the header is missing
+    std::array<uint8_t, kKnownHeaderCount> m_knownHeaders{};
+    std::string_view m_body;
+    // Materialized views and the adopted body, shared between copies and never modified
+    std::shared_ptr<const std::string> m_storage;
+    std::shared_ptr<const std::string> m_bodyStorage;
 };
 }  // namespace ioteye
 
@@ -25,13 +25,19 @@ SOFTWARE.
 #ifndef IOTEYE_HTTP_RESOURCE_HPP
 #define IOTEYE_HTTP_RESOURCE_HPP
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "ioteyeserver/httpserver/body_consumer.hpp"
+#include "ioteyeserver/httpserver/compression.hpp"
 #include "ioteyeserver/httpserver/http_request.hpp"
 #include "ioteyeserver/httpserver/http_response.hpp"
+#include "ioteyeserver/httpserver/response_cache.hpp"
 #include "ioteyeserver/logging.hpp"
 #include "ioteyeserver/types.hpp"
 #include "ioteyeserver/utils.hpp"
@@ -45,6 +51,11 @@ public:
     virtual std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req);
     virtual std::shared_ptr<HttpResponse> renderPUT(const HttpRequest& req);
     virtual std::shared_ptr<HttpResponse> renderDELETE(const HttpRequest& req);
+    virtual std::shared_ptr<HttpResponse> renderPATCH(const HttpRequest& req);
+    // Called over TCP once the head of a request with a body is read. A consumer gets the
+    // body while it arrives and answers the request instead of render*, nullptr (the
+    // default) collects the body into the request. Request views are valid only during the call
+    virtual std::shared_ptr<BodyConsumer> consumeBody(const HttpRequest& req);
 
 private:
     std::shared_ptr<HttpResponse> empty_render(const HttpRequest& req);
@@ -57,35 +68,85 @@ public:
     std::shared_ptr<HttpResourceHandler> getHandler() const {
         return m_handler;
     }
-    std::string getUri() const {
+    const std::string& getUri() const {
         return m_uri;
     }
-    std::regex getRegexUri() const {
+    const std::regex& getRegexUri() const {
         return m_regexUri;
     }
-    std::vector<std::string> getParamNames() const {
+    const std::vector<std::string>& getParamNames() const {
         return m_paramNames;
     }
+    const std::vector<ParamType>& getParamTypes() const {
+        return m_paramTypes;
+    }
     bool getIsValid() const {
         return m_isValid;
     }
     void setAllowing(HttpMethod_t httpMethod, bool allowed);
     void disallowAll();
     void allowAll();
-    bool isAllowed(HttpMethod_t httpMethod);
-    std::string getAllowedMethodsAsString();
-    std::vector<HttpMethod> getAllowedMethods();
+    bool isAllowed(HttpMethod_t httpMethod) const {
+        return httpMethod < HttpMethod::HTTP_METHOD_MAX && (m_allowedMethods & (1u << httpMethod));
+    }
+    // Value of the Allow header, rebuilt only when allowed methods change
+    const std::string& getAllowedMethodsAsString() const {
+        return m_allowHeader;
+    }
+    std::vector<HttpMethod> getAllowedMethods() const;
+    // Canned 405 and OPTIONS answers carrying the Allow header
+    std::shared_ptr<HttpResponse> getMethodNotAllowedResponse() const {
+        return m_methodNotAllowed->get();
+    }
+    std::shared_ptr<HttpResponse> getOptionsResponse() const {
+        return m_options->get();
+    }
+    // GET and HEAD are answered from the cache once enabled. Handlers which change the data
+    // keep the returned cache to invalidate it, successful unsafe methods invalidate the path
+    std::shared_ptr<ResponseCache> enableCache(ResponseCache::Config config);
+    std::shared_ptr<ResponseCache> getCache() const {
+        return m_cache;
+    }
+    // Overrides the server compression settings for this resource
+    void setCompression(CompressionConfig config) {
+        m_compression = config;
+    }
+    const std::optional<CompressionConfig>& getCompression() const {
+        return m_compression;
+    }
+
+    // Splits "name:type" from a pattern placeholder, false for an unknown type
+    static bool parseParamSpec(std::string_view spec, std::string& name, ParamType& type);
+    static bool matchesParamType(ParamType type, std::string_view value);
 
 private:
     bool createRegexFromURI(std::string uri);
+    void updateAllowHeader();
 
 private:
     std::shared_ptr<HttpResourceHandler> m_handler;
     std::string m_uri;
     std::regex m_regexUri;
     std::vector<std::string> m_paramNames;
+    std::vector<ParamType> m_paramTypes;
     bool m_isValid = false;
-    std::unordered_map<HttpMethod_t, bool> m_allowedMethods;
+    // Bit per HttpMethod
+    uint32_t m_allowedMethods = 0;
+    std::string m_allowHeader;
+    std::shared_ptr<const CannedResponse> m_methodNotAllowed;
+    std::shared_ptr<const CannedResponse> m_options;
+    std::shared_ptr<ResponseCache> m_cache;
+    std::optional<CompressionConfig> m_compression;
+};
+
+// Answers GET and HEAD with the same canned response, for constant resources
+class CannedResponseHandler : public HttpResourceHandler {
+public:
+    explicit CannedResponseHandler(HttpResponse response);
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override;
+
+private:
+    CannedResponse m_response;
 };
 }  // namespace ioteye
 
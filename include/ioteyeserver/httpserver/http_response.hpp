@@ -25,42 +25,205 @@ SOFTWARE.
 #ifndef IOTEYE_HTTP_RESPONSE_HPP
 #define IOTEYE_HTTP_RESPONSE_HPP
 
+#include <array>
 #include <asio.hpp>
+#include <atomic>
+#include <ctime>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 
 #include "ioteyeserver/http_status_codes.hpp"
+#include "ioteyeserver/httpserver/file_body.hpp"
 #include "ioteyeserver/logging.hpp"
+#include "ioteyeserver/small_vector.hpp"
+#include "ioteyeserver/types.hpp"
 
 namespace ioteye {
+class CompressedVariants;
+
+// Produces a body while it is sent. Each call appends the next piece to chunk, false means
+// the piece was the last one. An empty piece which isn't the last means nothing is ready yet,
+// see BodyNotifier
+using BodyGenerator = std::function<bool(std::string& chunk)>;
+
+// Tells the connection of a generated body that the next piece is ready. While the generator
+// has nothing to send the connection waits for resume() instead of asking it again
+class BodyNotifier {
+public:
+    // Asks the generator for the next piece. Can be called from any thread
+    void resume() {
+        std::function<void()> resume;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            resume = m_resume;
+        }
+        if (resume)
+            resume();
+    }
+
+private:
+    friend class TcpConnection;
+
+    void setResume(std::function<void()> resume) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_resume = std::move(resume);
+    }
+
+    std::mutex m_mutex;
+    std::function<void()> m_resume;
+};
+
 class HttpResponse {
 public:
-    HttpResponse(int statusCode = HttpStatusCode::OK, const std::string& body = "",
-                 const std::unordered_map<std::string, std::string>& headers = {});
+    // Typical responses carry a few headers, they fit in place without heap allocation
+    using Headers = util::SmallVector<std::pair<std::string, std::string>, 8>;
+
+    HttpResponse(int statusCode = HttpStatusCode::OK, const std::string& body = "", Headers headers = {});
+    // Reads the file of a file body, empty for a generated body
     std::string getBody() const;
-    std::string getHeader(const std::string& key) const;
+    // Empty for a file or a generated body
+    std::string_view getBodyView() const {
+        return m_bodyOwner ? m_sharedBody : std::string_view(m_body);
+    }
+    uint64_t getBodySize() const {
+        return m_file ? m_fileLength : getBodyView().size();
+    }
+    // Case-insensitive, empty when the header is missing
+    std::string getHeader(std::string_view key) const;
     int getStatusCode() const;
+    // A generated body isn't included, see loadBody()
     std::string toString() const;
+    // Status line with headers, followed by the body. The head is serialized into head unless
+    // the response is canned, so one response can be written by several writers at once.
+    // Buffers reference head and the response, both have to stay alive and unchanged until
+    // they are written. A file or a generated body isn't included, the connection sends it
+    // after the buffers. Unless empty, connection replaces the Connection header
+    std::array<asio::const_buffer, 2> toBuffers(std::string& head, std::string_view connection = {}) const;
+    // Replaces the header of the same name. Date is added to every response unless set here
     void setHeader(const std::string& key, const std::string& value);
     void setContentType(const std::string& contentType);
     void setBody(const std::string& body);
+    // Body stored elsewhere, e.g. a cached file. It's written without a copy, and owner keeps it
+    // alive as long as any copy of the response exists
+    void setSharedBody(std::string_view body, std::shared_ptr<const void> owner);
+    // Whole file as the body, advertised with Accept-Ranges so clients can resume
+    void setFileBody(std::shared_ptr<const FileBody> file);
+    const std::shared_ptr<const FileBody>& getFileBody() const {
+        return m_file;
+    }
+    uint64_t getFileOffset() const {
+        return m_fileOffset;
+    }
+    // Body of unknown length sent with Transfer-Encoding: chunked. The generator is called
+    // again only once the previous chunk is written, so memory stays bounded by one chunk.
+    // A generator which can run out of data before the body ends needs a notifier, without
+    // one an empty piece fails the response
+    void setBodyGenerator(BodyGenerator generator, std::shared_ptr<BodyNotifier> notifier = nullptr);
+    const BodyGenerator& getBodyGenerator() const {
+        return m_generator;
+    }
+    const std::shared_ptr<BodyNotifier>& getBodyNotifier() const {
+        return m_notifier;
+    }
+    // Narrows the body to length bytes from offset, for 206 Partial Content
+    void setBodyRange(uint64_t offset, uint64_t length);
     void addBody(const std::string& body);
     void setStatusCode(int statusCode);
+    // Answer to HEAD: headers describe the body, but the body itself isn't sent
+    void setHeadOnly(bool headOnly);
+    bool isHeadOnly() const;
+    // Shared by every request it answers, see CannedResponse
+    bool isCanned() const {
+        return m_isCanned;
+    }
+    // Set on canned responses only, shared by all copies of one CannedResponse
+    const std::shared_ptr<CompressedVariants>& getCompressedVariants() const {
+        return m_variants;
+    }
+
+private:
+    friend class CannedResponse;
+    friend std::shared_ptr<HttpResponse> makeMutable(std::shared_ptr<HttpResponse> response);
+
+    std::pair<std::string, std::string>* findHeader(std::string_view key);
+    std::string serializeHead(std::string_view connection = {}) const;
 
 private:
     int m_statusCode;
     std::string m_body;
-    std::unordered_map<std::string, std::string> m_headers;
+    // Set by setSharedBody(), m_body is unused then
+    std::shared_ptr<const void> m_bodyOwner;
+    std::string_view m_sharedBody;
+    // Set by setFileBody(), the body is the range of the file
+    std::shared_ptr<const FileBody> m_file;
+    uint64_t m_fileOffset = 0;
+    uint64_t m_fileLength = 0;
+    // Set by setBodyGenerator()
+    BodyGenerator m_generator;
+    std::shared_ptr<BodyNotifier> m_notifier;
+    Headers m_headers;
+    std::string m_head;
+    bool m_isHeadOnly = false;
+    // m_head is serialized already and the response is never changed again
+    bool m_isCanned = false;
+    std::shared_ptr<CompressedVariants> m_variants;
 };
+
+// Response serialized once and then shared by every request it answers, so serving it
+// costs a reference count increment and the write. The bytes are serialized again only
+// when the Date header changes, once a second at most.
+class CannedResponse {
+public:
+    explicit CannedResponse(HttpResponse response);
+    CannedResponse(const CannedResponse&) = delete;
+    CannedResponse& operator=(const CannedResponse&) = delete;
+
+    // Must not be changed, pass it through makeMutable() first
+    std::shared_ptr<HttpResponse> get() const;
+
+private:
+    HttpResponse m_response;
+    mutable std::shared_ptr<HttpResponse> m_current;
+    mutable std::atomic<std::time_t> m_currentTime{0};
+};
+
+// Compressed copies of one canned response. Each encoding is compressed by the first request
+// asking for it and then served canned as well
+class CompressedVariants {
+public:
+    std::shared_ptr<const CannedResponse> get(ContentEncoding encoding) const {
+        return std::atomic_load(&m_variants[static_cast<size_t>(encoding)]);
+    }
+    void set(ContentEncoding encoding, std::shared_ptr<const CannedResponse> variant) {
+        std::atomic_store(&m_variants[static_cast<size_t>(encoding)], std::move(variant));
+    }
+
+private:
+    std::array<std::shared_ptr<const CannedResponse>, static_cast<size_t>(ContentEncoding::ENCODING_MAX)> m_variants;
+};
+
+// Copy of the response which can be changed. Handlers may keep the responses they return and
+// answer other requests with them, so a response is never changed in place
+std::shared_ptr<HttpResponse> makeMutable(std::shared_ptr<HttpResponse> response);
+// Response with its file or generated body read into memory, for transports which can't
+// send them piece by piece
+std::shared_ptr<HttpResponse> loadBody(std::shared_ptr<HttpResponse> response);
+// Error responses are canned
 std::shared_ptr<HttpResponse> createBadRequestResponse();
 std::shared_ptr<HttpResponse> createNotFoundResponse();
 std::shared_ptr<HttpResponse> createMethodNotAllowed(const std::string& allowedMethods);
-void sendUdpResponse(const HttpResponse& response, std::shared_ptr<asio::ip::udp::socket> socket,
-                     asio::ip::udp::endpoint& destination);
-void sendTcpResponse(const HttpResponse& response, std::shared_ptr<asio::ip::tcp::socket> socket);
+std::shared_ptr<HttpResponse> createOptionsResponse(const std::string& allowedMethods);
+std::shared_ptr<HttpResponse> createErrorResponse(int statusCode);
+void sendUdpResponse(std::shared_ptr<HttpResponse> response, std::shared_ptr<asio::ip::udp::socket> socket,
+                     const asio::ip::udp::endpoint& destination);
+void sendTcpResponse(std::shared_ptr<HttpResponse> response, std::shared_ptr<asio::ip::tcp::socket> socket,
+                     std::function<void(const asio::error_code&)> onSent = nullptr);
 }  // namespace ioteye
 
 #endif  // IOTEYE_HTTP_RESPONSE_HPP
\ No newline at end of file
@@ -0,0 +1,108 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_RESPONSE_CACHE_HPP
+#define IOTEYE_RESPONSE_CACHE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ioteyeserver/httpserver/http_request.hpp"
+#include "ioteyeserver/httpserver/http_response.hpp"
+
+namespace ioteye {
+
+// Opt-in cache of GET answers for one resource. Entries hold fully serialized responses with
+// an ETag, so a hit costs a lookup, and a request whose If-None-Match carries that ETag gets
+// 304 Not Modified without the handler being called.
+class ResponseCache {
+public:
+    struct Config {
+        std::chrono::milliseconds ttl{1000};
+        // Route arguments or query parameters which change the answer, in addition to the path
+        std::vector<std::string> keyArgs;
+        std::vector<std::string> keyHeaders;
+        size_t maxEntries = 1024;
+    };
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t notModified = 0;
+    };
+
+    explicit ResponseCache(Config config);
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    // Cached answer for the request, render() is called on a miss. Only 200 OK is stored, its
+    // ETag is generated from the body unless render() sets one. The result is canned
+    std::shared_ptr<HttpResponse> respond(const HttpRequest& request,
+                                          const std::function<std::shared_ptr<HttpResponse>()>& render);
+    void invalidate();
+    // Drops entries of one path whatever their key arguments are
+    void invalidate(std::string_view path);
+
+    const Config& getConfig() const {
+        return m_config;
+    }
+    size_t size() const;
+    Stats getStats() const;
+
+    // Strong ETag of the body, quoted
+    static std::string makeETag(std::string_view body);
+    // Weak comparison against a list of entity tags (RFC 9110, 13.1.2)
+    static bool matchesIfNoneMatch(std::string_view ifNoneMatch, std::string_view etag);
+
+private:
+    struct Entry {
+        Entry(const HttpResponse& response, const HttpResponse& notModified);
+        std::chrono::steady_clock::time_point expires;
+        CannedResponse response;
+        CannedResponse notModified;
+        std::string etag;
+    };
+
+    std::string makeKey(const HttpRequest& request) const;
+    std::shared_ptr<const Entry> find(const std::string& key, std::chrono::steady_clock::time_point now) const;
+    std::shared_ptr<const Entry> store(std::string key, const HttpResponse& response,
+                                       std::chrono::steady_clock::time_point now);
+
+    Config m_config;
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const Entry>> m_entries;
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_misses{0};
+    std::atomic<size_t> m_notModified{0};
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_RESPONSE_CACHE_HPP
@@ -0,0 +1,88 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_ROUTER_HPP
+#define IOTEYE_ROUTER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ioteyeserver/httpserver/http_resource.hpp"
+
+namespace ioteye {
+
+// Radix tree over path segments. Chains of static segments are stored as one edge and
+// {param} segments capture one non-empty segment. Typed parameters ({id:int}, {ts:u64},
+// {name:alnum}) are checked with from_chars while matching, a segment of a wrong type
+// just doesn't match. Static edges take precedence over parameters, which are tried
+// from the most specific type, with backtracking when a branch doesn't lead to a resource.
+// Patterns the tree can't express (e.g. a parameter inside a segment) are matched by
+// their regex after the tree, in lexicographic order of their patterns once build() sorted
+// them, so overlapping ones route the same whatever order they were added in.
+// build() additionally puts routes without parameters into a perfect hash table, so an
+// exact uri is resolved by one hash and one comparison before the tree is walked.
+class Router {
+public:
+    struct Match {
+        std::shared_ptr<HttpResource> resource;
+        // Parameter names and values, values point into the matched uri
+        std::vector<std::pair<std::string_view, std::string_view>> args;
+    };
+
+    Router();
+    ~Router();
+    Router(Router&& other) noexcept;
+    Router& operator=(Router&& other) noexcept;
+
+    void addResource(std::shared_ptr<HttpResource> resource);
+    // Rebuilds the static route table from the routes added so far and sorts the regex routes
+    void build();
+    bool match(std::string_view uri, Match& match) const;
+
+private:
+    struct Node;
+    struct StaticRoute {
+        std::string uri;
+        std::shared_ptr<HttpResource> resource;
+    };
+
+    void insert(Node& node, const std::vector<std::string>& segments, size_t index,
+                std::shared_ptr<HttpResource> resource);
+    static bool matchNode(const Node& node, std::string_view rest, bool isDone, Match& match);
+
+private:
+    std::unique_ptr<Node> m_root;
+    std::vector<std::shared_ptr<HttpResource>> m_regexResources;
+    std::vector<std::shared_ptr<HttpResource>> m_staticResources;
+    // Hash and displace table: uri hash picks a bucket, bucket seed picks the slot
+    std::vector<uint32_t> m_staticSeeds;
+    std::vector<StaticRoute> m_staticTable;
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_ROUTER_HPP
@@ -0,0 +1,116 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_STATIC_FILES_HPP
+#define IOTEYE_STATIC_FILES_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "ioteyeserver/httpserver/http_request.hpp"
+#include "ioteyeserver/httpserver/http_resource.hpp"
+#include "ioteyeserver/httpserver/http_response.hpp"
+
+namespace ioteye {
+
+// Serves files below a directory, the route passes the file as the "path" argument, see
+// Webserver::Builder::setStaticDirectory(). Small files are kept in memory as canned responses
+// with Content-Type, Content-Length, ETag and Last-Modified serialized, so serving one costs a
+// lookup and the write. Cached files are checked for changes with stat() once per interval.
+class StaticFileHandler : public HttpResourceHandler {
+public:
+    struct Config {
+        // Larger files aren't cached, they are opened for each request and sent from disk
+        size_t maxCachedFileSize = 1024 * 1024;
+        // Total size of cached files, files beyond it are served uncached
+        size_t maxCacheSize = 64 * 1024 * 1024;
+        std::chrono::milliseconds checkInterval{1000};
+        // Served for the directory itself and for its subdirectories
+        std::string indexFile = "index.html";
+    };
+    struct Stats {
+        size_t hits = 0;
+        // Files read from disk, first requests and changed files
+        size_t loads = 0;
+        size_t notModified = 0;
+        size_t cachedFiles = 0;
+        size_t cachedBytes = 0;
+    };
+
+    explicit StaticFileHandler(std::string directory);
+    StaticFileHandler(std::string directory, Config config);
+
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override;
+    Stats getStats() const;
+
+    // Content-Type for the file extension, application/octet-stream for unknown ones
+    static std::string_view getMimeType(std::string_view path);
+    // Decoded path relative to the directory, false for paths leaving it
+    static bool resolvePath(std::string_view encodedPath, const std::string& indexFile, std::string& path);
+
+private:
+    struct FileInfo {
+        std::time_t modified = 0;
+        uint64_t size = 0;
+        uint64_t inode = 0;
+        bool isDirectory = false;
+    };
+    struct Entry {
+        Entry(const HttpResponse& response, const HttpResponse& notModified);
+        CannedResponse response;
+        CannedResponse notModified;
+        std::string etag;
+        std::string lastModified;
+        std::string filePath;
+        FileInfo info;
+        mutable std::atomic<int64_t> checkedAt{0};
+    };
+
+    static bool statFile(const std::string& filePath, FileInfo& info);
+    std::shared_ptr<const Entry> find(const std::string& path) const;
+    std::shared_ptr<HttpResponse> load(const std::string& path, const std::string& filePath, const FileInfo& info,
+                                       const HttpRequest& req);
+    std::shared_ptr<HttpResponse> respond(const Entry& entry, const HttpRequest& req);
+    void erase(const std::string& path);
+
+    std::string m_directory;
+    Config m_config;
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const Entry>> m_entries;
+    size_t m_cachedBytes = 0;
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_loads{0};
+    std::atomic<size_t> m_notModified{0};
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_STATIC_FILES_HPP
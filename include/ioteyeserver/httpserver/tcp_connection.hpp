@@ -0,0 +1,132 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_TCP_CONNECTION_HPP
+#define IOTEYE_TCP_CONNECTION_HPP
+
+#include <asio.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ioteyeserver/httpserver/body_consumer.hpp"
+#include "ioteyeserver/httpserver/buffer_pool.hpp"
+#include "ioteyeserver/httpserver/http_parser.hpp"
+#include "ioteyeserver/httpserver/http_request.hpp"
+#include "ioteyeserver/httpserver/http_response.hpp"
+
+namespace ioteye {
+class HttpResource;
+class Webserver;
+
+// Single persistent TCP connection. Reads requests until the client asks to close, the
+// request limit is reached or the connection is idle for too long. Pipelined requests are
+// answered in order, responses produced meanwhile are written together. A file body is
+// sent after the head of its response, at most m_maxInFlightBytes at a time, and a
+// generated body one chunk per write. A request body taken by a BodyConsumer is passed
+// on as it is read, and reading stops while the consumer is paused.
+class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
+public:
+    TcpConnection(Webserver& server, std::shared_ptr<asio::ip::tcp::socket> socket);
+
+    TcpConnection(const TcpConnection&) = delete;
+    TcpConnection& operator=(const TcpConnection&) = delete;
+
+    void start();
+    void close();
+
+private:
+    // Requests parsed ahead of unsent responses before reading is paused
+    static constexpr size_t kMaxPipelinedResponses = 32;
+
+    // Response may be shared with its handler and other connections, it is never changed
+    // here. Its head is serialized into storage of the write instead
+    struct Write {
+        std::shared_ptr<HttpResponse> response;
+        // Connection header the connection adds, empty to keep the one of the response
+        std::string_view connection;
+        std::string head;
+    };
+
+    void armIdleTimer();
+    void readRequest();
+    void handleReadable(const asio::error_code& error);
+    void handleRead(const asio::error_code& error, std::size_t length);
+    void processBuffer();
+    void handleRequest(HttpRequest request);
+    // Body consumer of the request whose head was just parsed
+    void startBody(HttpRequest& request);
+    bool consumeBody(std::string_view data);
+    void resumeBody();
+    void abortBody();
+    void queueResponse(std::shared_ptr<HttpResponse> response, std::string_view connection = {});
+    void flushResponses();
+    void handleWrite(const asio::error_code& error, std::size_t bytesTransfered);
+    // Continues the file body of the last active response
+    void sendFile();
+    // Writes the next chunk of the generated body of the last active response
+    void sendChunk();
+    void resumeChunk();
+    void finishWrite();
+
+private:
+    Webserver& m_server;
+    std::shared_ptr<asio::ip::tcp::socket> m_socket;
+    asio::steady_timer m_idleTimer;
+    HttpParser m_parser;
+    // Leased from the server pool only while received bytes are being parsed
+    BufferPool::Lease m_buffer;
+    // Bytes of m_buffer which are received but not parsed yet
+    size_t m_bufferBegin = 0;
+    size_t m_bufferEnd = 0;
+    // Responses waiting for the current write and the ones being written, they own
+    // the memory referenced by the gathered write
+    std::vector<Write> m_pendingWrites;
+    std::vector<Write> m_activeWrites;
+    // Remaining range of the file body being sent
+    uint64_t m_fileOffset = 0;
+    uint64_t m_fileRemaining = 0;
+    // Chunk of a generated body, or of the file where sendfile(2) isn't available
+    std::string m_chunk;
+    std::string m_chunkSize;
+    // Set while the generator has nothing to send and its notifier is awaited
+    bool m_isChunkParked = false;
+    std::shared_ptr<TcpConnection> m_parkedSelf;
+    // Resource of the current request, routed when the head of a request with a body is parsed
+    std::shared_ptr<HttpResource> m_resource;
+    bool m_isRouted = false;
+    // Set while the body of the current request goes to a consumer
+    std::shared_ptr<BodyConsumer> m_bodyConsumer;
+    bool m_isBodyPaused = false;
+    // Nothing is pending while the consumer is paused, the connection keeps itself alive
+    std::shared_ptr<TcpConnection> m_pausedSelf;
+    size_t m_requestsServed = 0;
+    bool m_keepAlive = true;
+    bool m_isReading = false;
+    bool m_isWriting = false;
+};
+}  // namespace ioteye
+
+#endif  // IOTEYE_TCP_CONNECTION_HPP
@@ -25,28 +25,45 @@ SOFTWARE.
 #ifndef IOTEYE_WEBSERVER_HPP
 #define IOTEYE_WEBSERVER_HPP
 
+#include <array>
 #include <asio.hpp>
 #include <asio/ts/buffer.hpp>
 #include <asio/ts/internet.hpp>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "ioteyeserver/httpserver/buffer_pool.hpp"
+#include "ioteyeserver/httpserver/byte_range.hpp"
+#include "ioteyeserver/httpserver/compression.hpp"
+#include "ioteyeserver/httpserver/http_date.hpp"
+#include "ioteyeserver/httpserver/http_parser.hpp"
 #include "ioteyeserver/httpserver/http_request.hpp"
 #include "ioteyeserver/httpserver/http_resource.hpp"
 #include "ioteyeserver/httpserver/http_response.hpp"
+#include "ioteyeserver/httpserver/router.hpp"
+#include "ioteyeserver/httpserver/static_files.hpp"
+#include "ioteyeserver/httpserver/tcp_connection.hpp"
 #include "ioteyeserver/logging.hpp"
 #include "ioteyeserver/types.hpp"
 #include "ioteyeserver/utils.hpp"
 
 namespace ioteye {
 using ResourceMap = std::unordered_map<std::string, std::shared_ptr<HttpResource>>;
+// Fill statistics of batched UDP receiving, fillHistogram[n] counts wakeups which got n datagrams
+struct UdpBatchStats {
+    size_t batches = 0;
+    size_t datagrams = 0;
+    std::vector<size_t> fillHistogram;
+};
 using MethodHandler =
     std::function<std::shared_ptr<HttpResponse>(std::shared_ptr<HttpResourceHandler>, const HttpRequest&)>;
 class Webserver {
@@ -63,56 +80,155 @@ public:
     void start();
     void shutdown();
 
+    BufferPool::Stats getBufferPoolStats() const;
+    UdpBatchStats getUdpBatchStats() const;
+    CompressionStats getCompressionStats() const;
+
     class Builder {
     public:
         Builder() = default;
         Builder& setTcpPort(int port);
         Builder& setUdpPort(int port);
         Builder& setUdpOn();
+        // Receive and send up to size datagrams per system call (recvmmsg/sendmmsg, Linux only)
+        Builder& setUdpBatchSize(size_t size);
+        // Number of receives kept outstanding on every UDP socket
+        Builder& setUdpReceiveDepth(size_t depth);
+        // Number of UDP sockets sharing the port through SO_REUSEPORT, 0 means one per I/O thread
+        Builder& setUdpSocketCount(size_t count);
         Builder& setBufferSize(size_t size);
+        // Number of preallocated I/O buffers shared by all connections
+        Builder& setBufferPoolSize(size_t count);
+        // Number of threads running the io_context
+        Builder& setThreadCount(size_t threadCount);
+        // Run TCP in N independent shards, each with its own io_context, thread and
+        // SO_REUSEPORT acceptor. 0 keeps a single io_context shared by setThreadCount threads
+        Builder& setShardCount(size_t shardCount);
+        // 0 means unlimited number of requests per connection
+        Builder& setMaxRequestsPerConnection(size_t maxRequests);
+        // 0 disables closing of idle keep-alive connections
+        Builder& setIdleTimeout(std::chrono::milliseconds timeout);
+        // Limits of request line with headers and of request body, in bytes
+        Builder& setMaxHeaderSize(size_t size);
+        Builder& setMaxBodySize(size_t size);
+        // Bytes of a file body a connection hands to the socket before it waits for the socket
+        // to become writable again, and the buffer size where sendfile(2) isn't available
+        Builder& setMaxInFlightBytes(size_t size);
+        // Compress response bodies for clients sending Accept-Encoding, resources can override it
+        Builder& setCompression(CompressionConfig config);
         Builder& setResource(const std::string& path, std::shared_ptr<HttpResourceHandler> resourceHandler);
         Builder& setResource(std::shared_ptr<HttpResource> resource);
+        // Constant GET/HEAD resource, the response is serialized once and shared
+        Builder& setCannedResponse(const std::string& path, HttpResponse response);
+        // Files below directory served under the uri prefix with GET/HEAD, see StaticFileHandler
+        Builder& setStaticDirectory(const std::string& prefix, const std::string& directory,
+                                    StaticFileHandler::Config config = StaticFileHandler::Config());
         Webserver build();
 
     private:
         int m_tcpPort = 8080;  // Default port
         int m_udpPort = 8081;  // Default port
         bool m_isUdpOn = false;
+        size_t m_udpBatchSize = 1;
+        size_t m_udpReceiveDepth = 1;
+        size_t m_udpSocketCount = 1;
         size_t m_bufferSize = 1024;
+        size_t m_bufferPoolSize = 256;
         size_t m_threadCount = 1;
+        size_t m_shardCount = 0;
+        size_t m_maxRequestsPerConnection = 1000;
+        std::chrono::milliseconds m_idleTimeout{std::chrono::seconds(15)};
+        size_t m_maxHeaderSize = 8192;
+        size_t m_maxBodySize = 1024 * 1024;
+        size_t m_maxInFlightBytes = 256 * 1024;
+        CompressionConfig m_compression{false};
         ResourceMap m_resourceMap;
+
+        friend class Webserver;
     };
 
 private:
-    Webserver(int tcpPort, int udpPort, bool udpOn, ResourceMap resourceMap, size_t bufferSize);
+    friend class TcpConnection;
+
+    explicit Webserver(Builder& builder);
+
+    // Independent TCP listener served by a single pinned thread
+    struct Shard {
+        asio::io_context ioContext{1};
+        asio::ip::tcp::acceptor acceptor{ioContext};
+        std::thread thread;
+    };
 
-    void acceptTcpConnection();
+    void openTcpListeners();
+    // Keeps the Date header text current while the server runs
+    void tickDate();
+    static void pinThreadToCore(std::thread& thread, size_t core);
+    void acceptTcpConnection(asio::ip::tcp::acceptor& acceptor);
     void handleTcpConnection(std::shared_ptr<asio::ip::tcp::socket> socketPtr);
 
-    void receiveUdpRequest();
-    void handleRequestData(const std::string& requestData,
-                           std::function<void(const ioteye::HttpResponse&)> sendResponse);
-    std::string getHeaderValue(const std::string& headers, const std::string& headerName);
-    std::shared_ptr<HttpResponse> handleRequest(const HttpRequest& request, const std::string& uriPattern);
-    bool matchUrl(HttpRequest& request, const std::shared_ptr<HttpResource> resource);
+    // Batched UDP state, defined in the source to keep socket headers out of the interface
+    struct UdpBatch;
+
+    void openUdpSockets();
+    void receiveUdpRequest(std::shared_ptr<asio::ip::udp::socket> socket);
+    void receiveUdpBatch(std::shared_ptr<asio::ip::udp::socket> socket, UdpBatch& batch);
+    void handleUdpBatch(std::shared_ptr<asio::ip::udp::socket> socket, UdpBatch& batch);
+    void sendUdpBatch(std::shared_ptr<asio::ip::udp::socket> socket, UdpBatch& batch);
+    void handleRequestData(const char* data, size_t length,
+                           std::function<void(std::shared_ptr<HttpResponse>)> sendResponse);
+    // Resource the URI routes to, with the route arguments set on request. nullptr when none does
+    std::shared_ptr<HttpResource> findResource(HttpRequest& request);
+    std::shared_ptr<HttpResponse> routeRequest(HttpRequest& request);
+    // Answers a request routed by findResource() already
+    std::shared_ptr<HttpResponse> routeRequest(const HttpRequest& request,
+                                               const std::shared_ptr<HttpResource>& resource);
+    // Consumer for the body of a request routed to resource, when its handler takes bodies while
+    // they arrive. nullptr when the body is to be collected instead
+    std::shared_ptr<BodyConsumer> createBodyConsumer(const HttpRequest& request,
+                                                     const std::shared_ptr<HttpResource>& resource);
+    std::shared_ptr<HttpResponse> finishBody(const HttpRequest& request, const HttpResource& resource,
+                                             BodyConsumer& consumer);
+    bool isKeepAlive(const HttpRequest& request);
+    std::shared_ptr<HttpResponse> handleRequest(const HttpRequest& request,
+                                                const std::shared_ptr<HttpResource>& resource);
 
 private:
     int m_tcpPort = 8080;  // Default tcp port
     int m_udpPort = 8081;  // Default udp port
     ResourceMap m_resourceMap;
+    // Built from m_resourceMap once, when the server is constructed
+    Router m_router;
     // TCP Socket
     asio::io_context m_ioContext;
     asio::ip::tcp::acceptor m_tcpAcceptor;
+    asio::steady_timer m_dateTimer;
     // UDP Socket
     bool m_isUdpOn = false;
-    std::shared_ptr<asio::ip::udp::socket> m_udpSocket;
-    asio::ip::udp::endpoint m_remoteEndpoint;
+    std::vector<std::shared_ptr<asio::ip::udp::socket>> m_udpSockets;
+    size_t m_udpBatchSize = 1;
+    size_t m_udpReceiveDepth = 1;
+    size_t m_udpSocketCount = 1;
+    // Batch state of every socket in m_udpSockets, empty when batching is off
+    std::vector<std::unique_ptr<UdpBatch>> m_udpBatches;
     // Server utils
     std::atomic<bool> m_keepRunning{false};
     std::mutex m_coutMutex;
-    std::unordered_map<HttpMethod, MethodHandler> m_methodHandlers;
-    std::thread m_ioContextThread;
+    // Indexed by HttpMethod, empty for methods answered by the server itself
+    std::array<MethodHandler, HttpMethod::HTTP_METHOD_MAX> m_methodHandlers;
+    std::vector<std::thread> m_ioContextThreads;
+    size_t m_threadCount = 1;
     size_t m_bufferSize = 1024;
+    size_t m_maxRequestsPerConnection = 1000;
+    std::chrono::milliseconds m_idleTimeout{std::chrono::seconds(15)};
+    size_t m_maxHeaderSize = 8192;
+    size_t m_maxBodySize = 1024 * 1024;
+    size_t m_maxInFlightBytes = 256 * 1024;
+    size_t m_shardCount = 0;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    size_t m_bufferPoolSize = 256;
+    std::shared_ptr<BufferPool> m_bufferPool;
+    CompressionConfig m_compression{false};
+    std::shared_ptr<ResponseCompressor> m_compressor;
 };
 }  // namespace ioteye
 
@@ -27,13 +27,21 @@ SOFTWARE.
 #define LOGGING_H
 
 #include <iostream>
+#include <mutex>
 #include <sstream>
 namespace ioteye::debug {
 #ifdef ENABLE_LOGGING
+inline std::mutex& logMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
 template <typename... Args>
 inline void log(Args&&... args) {
     std::ostringstream oss;
     (oss << ... << std::forward<Args>(args));
+    // Server threads log concurrently, keep lines whole
+    std::lock_guard<std::mutex> lock(logMutex());
     std::cout << "LOG: " << oss.str() << std::endl;
 }
 #else
@@ -0,0 +1,216 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_SMALL_VECTOR_HPP
+#define IOTEYE_SMALL_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ioteye::util {
+
+// Vector keeping up to N elements inside the object itself, the heap is used only once it
+// grows past that. Iterators are invalidated by any insertion, as with std::vector.
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(N > 0, "SmallVector needs room for at least one inline element");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+    SmallVector(std::initializer_list<T> items) {
+        reserve(items.size());
+        for (const T& item : items)
+            emplace_back(item);
+    }
+    SmallVector(const SmallVector& other) {
+        reserve(other.m_size);
+        for (const T& item : other)
+            emplace_back(item);
+    }
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        takeFrom(other);
+    }
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.m_size);
+            for (const T& item : other)
+                emplace_back(item);
+        }
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            clear();
+            releaseHeap();
+            takeFrom(other);
+        }
+        return *this;
+    }
+    ~SmallVector() {
+        clear();
+        releaseHeap();
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (m_size == m_capacity) {
+            // Arguments may refer to an element, build the new one before moving them
+            T item(std::forward<Args>(args)...);
+            grow(m_capacity * 2);
+            return *new (m_data + m_size++) T(std::move(item));
+        }
+        return *new (m_data + m_size++) T(std::forward<Args>(args)...);
+    }
+    void push_back(const T& item) {
+        emplace_back(item);
+    }
+    void push_back(T&& item) {
+        emplace_back(std::move(item));
+    }
+    void pop_back() {
+        m_data[--m_size].~T();
+    }
+    iterator erase(const_iterator position) {
+        iterator target = m_data + (position - m_data);
+        std::move(target + 1, end(), target);
+        pop_back();
+        return target;
+    }
+    void clear() {
+        std::destroy(m_data, m_data + m_size);
+        m_size = 0;
+    }
+    void reserve(size_t capacity) {
+        if (capacity > m_capacity)
+            grow(capacity);
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+    size_t capacity() const {
+        return m_capacity;
+    }
+    bool empty() const {
+        return m_size == 0;
+    }
+    // Elements are still in the inline storage
+    bool isInline() const {
+        return m_data == inlineData();
+    }
+    T* data() {
+        return m_data;
+    }
+    const T* data() const {
+        return m_data;
+    }
+    T& operator[](size_t index) {
+        return m_data[index];
+    }
+    const T& operator[](size_t index) const {
+        return m_data[index];
+    }
+    T& back() {
+        return m_data[m_size - 1];
+    }
+    const T& back() const {
+        return m_data[m_size - 1];
+    }
+    iterator begin() {
+        return m_data;
+    }
+    iterator end() {
+        return m_data + m_size;
+    }
+    const_iterator begin() const {
+        return m_data;
+    }
+    const_iterator end() const {
+        return m_data + m_size;
+    }
+
+private:
+    T* inlineData() {
+        return std::launder(reinterpret_cast<T*>(m_inline));
+    }
+    const T* inlineData() const {
+        return std::launder(reinterpret_cast<const T*>(m_inline));
+    }
+
+    void grow(size_t capacity) {
+        T* data = std::allocator<T>().allocate(capacity);
+        for (size_t i = 0; i < m_size; ++i) {
+            new (data + i) T(std::move_if_noexcept(m_data[i]));
+            m_data[i].~T();
+        }
+        releaseHeap();
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    void releaseHeap() {
+        if (!isInline())
+            std::allocator<T>().deallocate(m_data, m_capacity);
+        m_data = inlineData();
+        m_capacity = N;
+    }
+
+    // Expects this vector to be empty and inline
+    void takeFrom(SmallVector& other) {
+        if (other.isInline()) {
+            for (size_t i = 0; i < other.m_size; ++i)
+                new (m_data + i) T(std::move(other.m_data[i]));
+            m_size = other.m_size;
+            other.clear();
+            return;
+        }
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        other.m_data = other.inlineData();
+        other.m_size = 0;
+        other.m_capacity = N;
+    }
+
+private:
+    alignas(T) unsigned char m_inline[N * sizeof(T)];
+    T* m_data = inlineData();
+    size_t m_size = 0;
+    size_t m_capacity = N;
+};
+
+}  // namespace ioteye::util
+
+#endif  // IOTEYE_SMALL_VECTOR_HPP
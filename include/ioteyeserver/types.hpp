@@ -38,9 +38,19 @@ enum HttpMethod {
     HTTP_POST,
     HTTP_PUT,
     HTTP_DELETE,
+    HTTP_HEAD,
+    HTTP_OPTIONS,
+    HTTP_PATCH,
     HTTP_METHOD_MAX,
 };
 
+// Route parameter written as {name:int}, {name:u64}, {name:alnum} or {name:path}, plain {name} is
+// STRING. PATH is the last one and takes the rest of the uri, slashes included
+enum class ParamType { STRING, INT, U64, ALNUM, PATH };
+
+// Content coding of a response body (RFC 9110, 8.4.1)
+enum class ContentEncoding { IDENTITY, GZIP, DEFLATE, ENCODING_MAX };
+
 }  // namespace ioteye
 
 #endif  // IOTEYE_TYPES_HPP
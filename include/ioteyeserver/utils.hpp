@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -34,8 +35,9 @@ SOFTWARE.
 
 namespace ioteye::util {
 std::vector<std::string> splitString(const std::string& str, char delimiter);
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs);
 
-HttpMethod stringToHttpMethod(const std::string& httpMethodName);
+HttpMethod stringToHttpMethod(std::string_view httpMethodName);
 std::string httpMethodToString(HttpMethod_t httpMethodCode);
 
 }  // namespace ioteye::util
@@ -0,0 +1,122 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/buffer_pool.hpp"
+
+#include <algorithm>
+
+namespace ioteye {
+
+namespace {
+constexpr uint64_t kSlotMask = 0xffffffffu;
+
+uint64_t nextHead(uint64_t head, uint32_t slot) {
+    return (((head >> 32) + 1) << 32) | slot;
+}
+}  // namespace
+
+BufferPool::Lease::Lease(std::shared_ptr<BufferPool> pool, char* data, size_t size, uint32_t slot)
+    : m_pool(std::move(pool)), m_data(data), m_size(size), m_slot(slot) {
+}
+
+BufferPool::Lease::Lease(Lease&& other) noexcept
+    : m_pool(std::move(other.m_pool)), m_data(other.m_data), m_size(other.m_size), m_slot(other.m_slot) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept {
+    if (this == &other)
+        return *this;
+    release();
+    m_pool = std::move(other.m_pool);
+    m_data = other.m_data;
+    m_size = other.m_size;
+    m_slot = other.m_slot;
+    other.m_data = nullptr;
+    other.m_size = 0;
+    return *this;
+}
+
+BufferPool::Lease::~Lease() {
+    release();
+}
+
+void BufferPool::Lease::release() {
+    if (!m_data)
+        return;
+    m_pool->giveBack(m_data, m_slot);
+    m_pool.reset();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+BufferPool::BufferPool(size_t bufferSize, size_t capacity)
+    : m_bufferSize(bufferSize),
+      m_capacity(std::min<size_t>(capacity, kSlotMask - 1)),
+      m_slab(new char[m_bufferSize * m_capacity]),
+      m_next(new std::atomic<uint32_t>[m_capacity]) {
+    for (size_t i = 0; i < m_capacity; ++i)
+        m_next[i].store(i + 1 < m_capacity ? static_cast<uint32_t>(i + 2) : 0, std::memory_order_relaxed);
+    m_head.store(m_capacity > 0 ? 1 : 0, std::memory_order_release);
+}
+
+BufferPool::Lease BufferPool::acquire() {
+    m_inUse.fetch_add(1, std::memory_order_relaxed);
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    while (head & kSlotMask) {
+        auto slot = static_cast<uint32_t>(head & kSlotMask);
+        uint32_t next = m_next[slot - 1].load(std::memory_order_relaxed);
+        if (m_head.compare_exchange_weak(head, nextHead(head, next), std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return Lease(shared_from_this(), m_slab.get() + (slot - 1) * m_bufferSize, m_bufferSize, slot);
+        }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return Lease(shared_from_this(), new char[m_bufferSize], m_bufferSize, 0);
+}
+
+void BufferPool::giveBack(char* data, uint32_t slot) {
+    m_inUse.fetch_sub(1, std::memory_order_relaxed);
+    if (slot == 0) {
+        delete[] data;
+        return;
+    }
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    do {
+        m_next[slot - 1].store(static_cast<uint32_t>(head & kSlotMask), std::memory_order_relaxed);
+    } while (!m_head.compare_exchange_weak(head, nextHead(head, slot), std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+BufferPool::Stats BufferPool::getStats() const {
+    Stats stats;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.inUse = m_inUse.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace ioteye
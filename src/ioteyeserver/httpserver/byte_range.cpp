@@ -0,0 +1,143 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/byte_range.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <string>
+
+#include "ioteyeserver/http_status_codes.hpp"
+#include "ioteyeserver/utils.hpp"
+
+namespace ioteye {
+namespace {
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.remove_suffix(1);
+    return value;
+}
+
+bool parsePosition(std::string_view text, uint64_t& position) {
+    if (text.empty())
+        return false;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), position);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+void appendNumber(std::string& out, uint64_t number) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+}  // namespace
+
+namespace util {
+RangeStatus parseRange(std::string_view range, uint64_t size, ByteRange& byteRange) {
+    range = trim(range);
+    if (range.size() < 6 || !equalsIgnoreCase(range.substr(0, 6), "bytes="))
+        return RangeStatus::IGNORED;
+    std::string_view spec = trim(range.substr(6));
+    size_t dash = spec.find('-');
+    if (dash == std::string_view::npos || spec.find(',') != std::string_view::npos)
+        return RangeStatus::IGNORED;
+    std::string_view first = trim(spec.substr(0, dash));
+    std::string_view last = trim(spec.substr(dash + 1));
+
+    uint64_t start = 0;
+    uint64_t end = 0;
+    if (first.empty()) {
+        // Suffix range, "-500" is the last 500 bytes
+        uint64_t suffix;
+        if (!parsePosition(last, suffix))
+            return RangeStatus::IGNORED;
+        if (suffix == 0 || size == 0)
+            return RangeStatus::UNSATISFIABLE;
+        byteRange.length = std::min(suffix, size);
+        byteRange.offset = size - byteRange.length;
+        return RangeStatus::SATISFIABLE;
+    }
+    if (!parsePosition(first, start))
+        return RangeStatus::IGNORED;
+    if (last.empty()) {
+        end = UINT64_MAX;
+    } else if (!parsePosition(last, end) || end < start) {
+        return RangeStatus::IGNORED;
+    }
+    if (start >= size)
+        return RangeStatus::UNSATISFIABLE;
+    byteRange.offset = start;
+    byteRange.length = std::min(end, size - 1) - start + 1;
+    return RangeStatus::SATISFIABLE;
+}
+
+bool ifRangeMatches(std::string_view ifRange, std::string_view etag, std::string_view lastModified) {
+    ifRange = trim(ifRange);
+    if (!ifRange.empty() && (ifRange.front() == '"' || ifRange.substr(0, 2) == "W/"))
+        // Strong comparison, weak tags never match
+        return ifRange.front() == '"' && !etag.empty() && etag.front() == '"' && ifRange == etag;
+    return !ifRange.empty() && ifRange == lastModified;
+}
+}  // namespace util
+
+std::shared_ptr<HttpResponse> applyRange(const HttpRequest& request, std::shared_ptr<HttpResponse> response) {
+    if (!response || request.getMethod() != HttpMethod::HTTP_GET || response->getStatusCode() != HttpStatusCode::OK)
+        return response;
+    std::string_view range = request.getHeader("Range");
+    if (range.empty() || response->getHeader("Accept-Ranges") != "bytes" || response->getBodyGenerator() ||
+        !response->getHeader("Content-Encoding").empty())
+        return response;
+    std::string_view ifRange = request.getHeader("If-Range");
+    if (!ifRange.empty() &&
+        !util::ifRangeMatches(ifRange, response->getHeader("ETag"), response->getHeader("Last-Modified")))
+        return response;
+
+    uint64_t size = response->getBodySize();
+    ByteRange byteRange;
+    util::RangeStatus status = util::parseRange(range, size, byteRange);
+    if (status == util::RangeStatus::IGNORED)
+        return response;
+    std::string contentRange = "bytes ";
+    if (status == util::RangeStatus::UNSATISFIABLE) {
+        auto unsatisfiable = makeMutable(createErrorResponse(HttpStatusCode::RANGE_NOT_SATISFIABLE));
+        contentRange += "*/";
+        appendNumber(contentRange, size);
+        unsatisfiable->setHeader("Content-Range", contentRange);
+        return unsatisfiable;
+    }
+    appendNumber(contentRange, byteRange.offset);
+    contentRange += '-';
+    appendNumber(contentRange, byteRange.offset + byteRange.length - 1);
+    contentRange += '/';
+    appendNumber(contentRange, size);
+    // Shared and file bodies are narrowed without copying the bytes
+    auto partial = makeMutable(std::move(response));
+    partial->setStatusCode(HttpStatusCode::PARTIAL_CONTENT);
+    partial->setHeader("Content-Range", contentRange);
+    partial->setBodyRange(byteRange.offset, byteRange.length);
+    return partial;
+}
+}  // namespace ioteye
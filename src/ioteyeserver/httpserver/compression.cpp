@@ -0,0 +1,238 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/compression.hpp"
+
+#include <zlib.h>
+
+#include <array>
+#include <cctype>
+
+#include "ioteyeserver/logging.hpp"
+#include "ioteyeserver/utils.hpp"
+
+namespace ioteye {
+namespace {
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.remove_suffix(1);
+    return value;
+}
+
+// Weight of a coding in thousandths, "q=0.5" is 500. Missing or malformed weight is 1
+int parseQValue(std::string_view params) {
+    while (!params.empty()) {
+        size_t semicolon = params.find(';');
+        std::string_view param = trim(params.substr(0, semicolon));
+        params.remove_prefix(semicolon == std::string_view::npos ? params.size() : semicolon + 1);
+        if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=')
+            continue;
+        std::string_view value = param.substr(2);
+        if (value.empty() || (value[0] != '0' && value[0] != '1'))
+            return 1000;
+        int weight = (value[0] - '0') * 1000;
+        if (value.size() > 2 && value[1] == '.') {
+            int scale = 100;
+            for (size_t i = 2; i < value.size() && i < 5 && std::isdigit(static_cast<unsigned char>(value[i])); ++i) {
+                weight += (value[i] - '0') * scale;
+                scale /= 10;
+            }
+        }
+        return weight > 1000 ? 1000 : weight;
+    }
+    return 1000;
+}
+
+bool containsIgnoreCase(std::string_view text, std::string_view part) {
+    for (size_t i = 0; i + part.size() <= text.size(); ++i) {
+        if (util::equalsIgnoreCase(text.substr(i, part.size()), part))
+            return true;
+    }
+    return false;
+}
+
+bool startsWithIgnoreCase(std::string_view text, std::string_view prefix) {
+    return text.size() >= prefix.size() && util::equalsIgnoreCase(text.substr(0, prefix.size()), prefix);
+}
+}  // namespace
+
+namespace util {
+ContentEncoding negotiateContentEncoding(std::string_view acceptEncoding) {
+    int gzip = -1;
+    int deflate = -1;
+    int any = -1;
+    while (!acceptEncoding.empty()) {
+        size_t comma = acceptEncoding.find(',');
+        std::string_view element = acceptEncoding.substr(0, comma);
+        acceptEncoding.remove_prefix(comma == std::string_view::npos ? acceptEncoding.size() : comma + 1);
+        size_t semicolon = element.find(';');
+        std::string_view coding = trim(element.substr(0, semicolon));
+        int weight = semicolon == std::string_view::npos ? 1000 : parseQValue(element.substr(semicolon + 1));
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip"))
+            gzip = weight;
+        else if (equalsIgnoreCase(coding, "deflate"))
+            deflate = weight;
+        else if (coding == "*")
+            any = weight;
+    }
+    // "*" stands for the codings which aren't listed
+    if (gzip < 0)
+        gzip = any;
+    if (deflate < 0)
+        deflate = any;
+    if (gzip <= 0 && deflate <= 0)
+        return ContentEncoding::IDENTITY;
+    return gzip >= deflate ? ContentEncoding::GZIP : ContentEncoding::DEFLATE;
+}
+
+std::string_view contentEncodingName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::GZIP:
+            return "gzip";
+        case ContentEncoding::DEFLATE:
+            return "deflate";
+        default:
+            return "identity";
+    }
+}
+
+bool isCompressibleType(std::string_view contentType) {
+    contentType = contentType.substr(0, contentType.find(';'));
+    static constexpr std::array<std::string_view, 4> kTypes = {"application/json", "application/javascript",
+                                                               "application/xml", "image/svg+xml"};
+    if (startsWithIgnoreCase(contentType, "text/"))
+        return true;
+    for (std::string_view type : kTypes) {
+        if (equalsIgnoreCase(trim(contentType), type))
+            return true;
+    }
+    // Structured syntax suffixes, "application/vnd.api+json"
+    return containsIgnoreCase(contentType, "+json") || containsIgnoreCase(contentType, "+xml");
+}
+
+std::string compress(std::string_view data, ContentEncoding encoding, int level) {
+    if (encoding != ContentEncoding::GZIP && encoding != ContentEncoding::DEFLATE)
+        return {};
+    z_stream stream{};
+    // 15 bits of window give the zlib format, 16 more ask for the gzip wrapper instead
+    int windowBits = encoding == ContentEncoding::GZIP ? 15 + 16 : 15;
+    if (deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return {};
+    std::string out(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        debug::log("compress: deflate failed with ", result);
+        return {};
+    }
+    return out;
+}
+}  // namespace util
+
+std::shared_ptr<HttpResponse> ResponseCompressor::compress(const HttpRequest& request, const CompressionConfig& config,
+                                                           std::shared_ptr<HttpResponse> response) {
+    // HEAD answers carry no body, their headers describe the identity one. File and generated
+    // bodies are never held in memory, they are sent as is
+    if (!config.enabled || !response || response->isHeadOnly() || response->getFileBody() ||
+        response->getBodyGenerator())
+        return response;
+    size_t bodySize = response->getBodyView().size();
+    int status = response->getStatusCode();
+    if (bodySize < config.minSize || status < 200 || status >= 300 || status == HttpStatusCode::NO_CONTENT ||
+        status == HttpStatusCode::PARTIAL_CONTENT)
+        return response;
+    ContentEncoding encoding = util::negotiateContentEncoding(request.getHeader("Accept-Encoding"));
+    if (encoding == ContentEncoding::IDENTITY)
+        return response;
+    if (!response->getHeader("Content-Encoding").empty() ||
+        !util::isCompressibleType(response->getHeader("Content-Type")))
+        return response;
+
+    const auto& variants = response->getCompressedVariants();
+    if (variants) {
+        if (auto variant = variants->get(encoding)) {
+            auto compressed = variant->get();
+            // Body which didn't shrink is remembered as the identity one
+            if (compressed->getBodyView().size() >= bodySize)
+                return response;
+            return served(std::move(compressed), bodySize);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string body = util::compress(response->getBodyView(), encoding, config.level);
+    m_compressNanoseconds.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+        std::memory_order_relaxed);
+    m_compressions.fetch_add(1, std::memory_order_relaxed);
+
+    bool isSmaller = !body.empty() && body.size() < bodySize;
+    HttpResponse compressed(*response);
+    if (isSmaller) {
+        compressed.setBody(body);
+        compressed.setHeader("Content-Encoding", std::string(util::contentEncodingName(encoding)));
+        std::string vary = compressed.getHeader("Vary");
+        if (vary.empty())
+            compressed.setHeader("Vary", "Accept-Encoding");
+        else if (vary != "*" && !containsIgnoreCase(vary, "Accept-Encoding"))
+            compressed.setHeader("Vary", vary + ", Accept-Encoding");
+        // Bytes differ from the identity body, but the ETag still has to match If-None-Match
+        std::string etag = compressed.getHeader("ETag");
+        if (!etag.empty() && etag.compare(0, 2, "W/") != 0)
+            compressed.setHeader("ETag", "W/" + etag);
+    }
+    if (variants) {
+        auto variant = std::make_shared<const CannedResponse>(std::move(compressed));
+        variants->set(encoding, variant);
+        return isSmaller ? served(variant->get(), bodySize) : response;
+    }
+    if (!isSmaller)
+        return response;
+    return served(std::make_shared<HttpResponse>(std::move(compressed)), bodySize);
+}
+
+std::shared_ptr<HttpResponse> ResponseCompressor::served(std::shared_ptr<HttpResponse> response, size_t bytesIn) {
+    m_responses.fetch_add(1, std::memory_order_relaxed);
+    m_bytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+    m_bytesOut.fetch_add(response->getBodyView().size(), std::memory_order_relaxed);
+    return response;
+}
+
+CompressionStats ResponseCompressor::getStats() const {
+    CompressionStats stats;
+    stats.responses = m_responses.load(std::memory_order_relaxed);
+    stats.compressions = m_compressions.load(std::memory_order_relaxed);
+    stats.bytesIn = m_bytesIn.load(std::memory_order_relaxed);
+    stats.bytesOut = m_bytesOut.load(std::memory_order_relaxed);
+    stats.compressTime = std::chrono::nanoseconds(m_compressNanoseconds.load(std::memory_order_relaxed));
+    return stats;
+}
+}  // namespace ioteye
@@ -0,0 +1,187 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/delimiter_scanner.hpp"
+
+#include <array>
+
+#if defined(__GNUC__)
+#define IOTEYE_ALWAYS_INLINE __attribute__((always_inline)) inline
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define IOTEYE_SCANNER_X86
+#include <immintrin.h>
+#endif
+#else
+#define IOTEYE_ALWAYS_INLINE inline
+#endif
+
+namespace ioteye {
+
+namespace {
+// Unused delimiter slots repeat the first one
+struct Delimiters {
+    explicit Delimiters(std::string_view delimiters) {
+        for (size_t i = 0; i < DelimiterScanner::kMaxDelimiters; ++i)
+            chars[i] = delimiters.empty() ? '\0' : delimiters[i < delimiters.size() ? i : 0];
+    }
+    char chars[DelimiterScanner::kMaxDelimiters];
+};
+
+constexpr std::array<bool, 256> makeTokenTable() {
+    std::array<bool, 256> table{};
+    for (int c = '0'; c <= '9'; ++c)
+        table[c] = true;
+    for (int c = 'a'; c <= 'z'; ++c)
+        table[c] = true;
+    for (int c = 'A'; c <= 'Z'; ++c)
+        table[c] = true;
+    for (char c : std::string_view("!#$%&'*+-.^_`|~"))
+        table[static_cast<unsigned char>(c)] = true;
+    return table;
+}
+
+constexpr std::array<bool, 256> kTokenTable = makeTokenTable();
+
+// Always inlined, so that inside the AVX2 function they are VEX encoded as well:
+// switching between VEX and legacy SSE code costs more than short lines take to scan
+IOTEYE_ALWAYS_INLINE size_t scanScalar(const char* data, size_t from, size_t length, const Delimiters& delimiters) {
+    for (size_t i = from; i < length; ++i) {
+        char c = data[i];
+        if (c == delimiters.chars[0] || c == delimiters.chars[1] || c == delimiters.chars[2] ||
+            c == delimiters.chars[3] || DelimiterScanner::isControl(static_cast<unsigned char>(c)))
+            return i;
+    }
+    return length;
+}
+
+#ifdef IOTEYE_SCANNER_X86
+// Bit per byte of the 16 at data which stops the scan
+IOTEYE_ALWAYS_INLINE unsigned stopMask16(const char* data, const Delimiters& delimiters) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i found = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(delimiters.chars[0])),
+                     _mm_cmpeq_epi8(block, _mm_set1_epi8(delimiters.chars[1]))),
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(delimiters.chars[2])),
+                     _mm_cmpeq_epi8(block, _mm_set1_epi8(delimiters.chars[3]))));
+    // Signed compare, bytes from 0x80 are negative and stay allowed
+    __m128i control = _mm_and_si128(_mm_cmplt_epi8(block, _mm_set1_epi8(0x20)),
+                                    _mm_cmpgt_epi8(block, _mm_set1_epi8(-1)));
+    control = _mm_andnot_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')), control);
+    found = _mm_or_si128(found, _mm_or_si128(control, _mm_cmpeq_epi8(block, _mm_set1_epi8(0x7f))));
+    return static_cast<unsigned>(_mm_movemask_epi8(found));
+}
+
+size_t scanSse2(const char* data, size_t length, const Delimiters& delimiters) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        unsigned mask = stopMask16(data + i, delimiters);
+        if (mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return scanScalar(data, i, length, delimiters);
+}
+
+__attribute__((target("avx2"))) size_t scanAvx2(const char* data, size_t length, const Delimiters& delimiters) {
+    const __m256i first = _mm256_set1_epi8(delimiters.chars[0]);
+    const __m256i second = _mm256_set1_epi8(delimiters.chars[1]);
+    const __m256i third = _mm256_set1_epi8(delimiters.chars[2]);
+    const __m256i fourth = _mm256_set1_epi8(delimiters.chars[3]);
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i minusOne = _mm256_set1_epi8(-1);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i found =
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, first), _mm256_cmpeq_epi8(block, second)),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(block, third), _mm256_cmpeq_epi8(block, fourth)));
+        __m256i control = _mm256_and_si256(_mm256_cmpgt_epi8(space, block), _mm256_cmpgt_epi8(block, minusOne));
+        control = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, tab), control);
+        found = _mm256_or_si256(found, _mm256_or_si256(control, _mm256_cmpeq_epi8(block, del)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(found));
+        if (mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    if (i + 16 <= length) {
+        unsigned mask = stopMask16(data + i, delimiters);
+        if (mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        i += 16;
+    }
+    return scanScalar(data, i, length, delimiters);
+}
+#endif
+
+using ScanFunction = size_t (*)(const char*, size_t, const Delimiters&);
+
+struct Implementation {
+    ScanFunction scan;
+    const char* name;
+};
+
+Implementation selectImplementation() {
+#ifdef IOTEYE_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {scanAvx2, "avx2"};
+    return {scanSse2, "sse2"};
+#else
+    return {[](const char* data, size_t length, const Delimiters& delimiters) {
+                return scanScalar(data, 0, length, delimiters);
+            },
+            "scalar"};
+#endif
+}
+
+const Implementation& getImplementation() {
+    static const Implementation implementation = selectImplementation();
+    return implementation;
+}
+}  // namespace
+
+size_t DelimiterScanner::find(const char* data, size_t length, std::string_view delimiters) {
+    return getImplementation().scan(data, length, Delimiters(delimiters));
+}
+
+size_t DelimiterScanner::findScalar(const char* data, size_t length, std::string_view delimiters) {
+    return scanScalar(data, 0, length, Delimiters(delimiters));
+}
+
+const char* DelimiterScanner::getImplementationName() {
+    return getImplementation().name;
+}
+
+bool DelimiterScanner::isTokenChar(unsigned char c) {
+    return kTokenTable[c];
+}
+
+size_t DelimiterScanner::findTokenEnd(const char* data, size_t length) {
+    size_t i = 0;
+    while (i < length && kTokenTable[static_cast<unsigned char>(data[i])])
+        ++i;
+    return i;
+}
+
+}  // namespace ioteye
@@ -0,0 +1,104 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/file_body.hpp"
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <ios>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace ioteye {
+#ifdef _WIN32
+std::shared_ptr<FileBody> FileBody::open(const std::string& path) {
+    struct _stat64 status;
+    if (_stat64(path.c_str(), &status) != 0 || (status.st_mode & _S_IFMT) != _S_IFREG)
+        return nullptr;
+    std::shared_ptr<FileBody> body(new FileBody(static_cast<uint64_t>(status.st_size), status.st_mtime));
+    body->m_stream.open(path, std::ios::binary);
+    if (!body->m_stream)
+        return nullptr;
+    return body;
+}
+
+FileBody::FileBody(uint64_t size, std::time_t modified) : m_size(size), m_modified(modified) {
+}
+
+FileBody::~FileBody() = default;
+
+long long FileBody::read(uint64_t offset, char* out, size_t length) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stream.clear();
+    if (!m_stream.seekg(static_cast<std::streamoff>(offset)))
+        return -1;
+    m_stream.read(out, static_cast<std::streamsize>(length));
+    if (m_stream.bad())
+        return -1;
+    return static_cast<long long>(m_stream.gcount());
+}
+#else
+std::shared_ptr<FileBody> FileBody::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (status.st_mode & S_IFMT) != S_IFREG) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::shared_ptr<FileBody> body(new FileBody(static_cast<uint64_t>(status.st_size), status.st_mtime));
+    body->m_fd = fd;
+    return body;
+}
+
+FileBody::FileBody(uint64_t size, std::time_t modified) : m_size(size), m_modified(modified) {
+}
+
+FileBody::~FileBody() {
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+long long FileBody::read(uint64_t offset, char* out, size_t length) const {
+    size_t total = 0;
+    while (total < length) {
+        ssize_t count = pread(m_fd, out + total, length - total, static_cast<off_t>(offset + total));
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0)
+            return -1;
+        if (count == 0)
+            break;
+        total += static_cast<size_t>(count);
+    }
+    return static_cast<long long>(total);
+}
+#endif
+}  // namespace ioteye
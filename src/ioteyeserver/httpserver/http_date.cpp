@@ -0,0 +1,106 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/http_date.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace ioteye {
+
+namespace {
+constexpr size_t kDateLength = 29;
+
+// Second of the last tick, 0 when nobody ticks
+std::atomic<std::time_t> g_tickedTime{0};
+
+char* writeDigits(char* out, int value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+void formatInto(std::time_t time, char* out) {
+    static constexpr const char* kDays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static constexpr const char* kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                              "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &time);
+#else
+    gmtime_r(&time, &tm);
+#endif
+    // IMF-fixdate has a fixed width, every field is written in place to fill kDateLength bytes
+    std::memcpy(out, kDays[tm.tm_wday], 3);
+    std::memcpy(out + 3, ", ", 2);
+    out = writeDigits(out + 5, tm.tm_mday, 2);
+    *out++ = ' ';
+    std::memcpy(out, kMonths[tm.tm_mon], 3);
+    *(out + 3) = ' ';
+    out = writeDigits(out + 4, std::clamp(tm.tm_year + 1900, 0, 9999), 4);
+    *out++ = ' ';
+    out = writeDigits(out, tm.tm_hour, 2);
+    *out++ = ':';
+    out = writeDigits(out, tm.tm_min, 2);
+    *out++ = ':';
+    out = writeDigits(out, std::min(tm.tm_sec, 59), 2);
+    std::memcpy(out, " GMT", 5);
+}
+}  // namespace
+
+std::string_view HttpDate::now() {
+    // Every thread formats its own copy once per second, nothing is shared but the time
+    thread_local std::time_t cachedTime = 0;
+    thread_local char cachedText[kDateLength + 1];
+    std::time_t time = currentTime();
+    if (time != cachedTime) {
+        formatInto(time, cachedText);
+        cachedTime = time;
+    }
+    return std::string_view(cachedText, kDateLength);
+}
+
+std::time_t HttpDate::currentTime() {
+    std::time_t time = g_tickedTime.load(std::memory_order_relaxed);
+    return time != 0 ? time : std::time(nullptr);
+}
+
+std::string HttpDate::format(std::time_t time) {
+    char text[kDateLength + 1];
+    formatInto(time, text);
+    return std::string(text, kDateLength);
+}
+
+void HttpDate::tick() {
+    g_tickedTime.store(std::time(nullptr), std::memory_order_relaxed);
+}
+
+void HttpDate::stopTicking() {
+    g_tickedTime.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace ioteye
@@ -0,0 +1,370 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/http_parser.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include "ioteyeserver/httpserver/delimiter_scanner.hpp"
+#include "ioteyeserver/logging.hpp"
+#include "ioteyeserver/utils.hpp"
+
+namespace ioteye {
+
+namespace {
+std::string_view trimWhitespace(std::string_view str) {
+    size_t start = str.find_first_not_of(" \t");
+    if (start == std::string_view::npos)
+        return {};
+    size_t end = str.find_last_not_of(" \t");
+    return str.substr(start, end - start + 1);
+}
+}  // namespace
+
+HttpParser::HttpParser(size_t maxHeaderSize, size_t maxBodySize)
+    : m_maxHeaderSize(maxHeaderSize), m_maxBodySize(maxBodySize) {
+}
+
+size_t HttpParser::parse(const char* data, size_t length) {
+    size_t consumed = 0;
+    m_isPaused = false;
+    while (consumed < length && !m_isPaused && m_state != ParseState::COMPLETE && m_state != ParseState::FAILED) {
+        if (m_state != ParseState::BODY)
+            consumed += parseLines(data + consumed, length - consumed);
+        else if (m_isChunked)
+            consumed += parseChunked(data + consumed, length - consumed);
+        else
+            consumed += parseBody(data + consumed, length - consumed);
+    }
+    // The caller reuses data once it returns, a request still in progress keeps a copy
+    if (m_hasBorrowedViews && (m_isPaused || (m_state != ParseState::COMPLETE && m_state != ParseState::FAILED))) {
+        m_request.materialize();
+        m_hasBorrowedViews = false;
+    }
+    return consumed;
+}
+
+void HttpParser::reset() {
+    m_state = ParseState::REQUEST_LINE;
+    m_errorStatus = HttpStatusCode::BAD_REQUEST;
+    m_headerSize = 0;
+    m_contentLength = 0;
+    m_hasContentLength = false;
+    m_bodyReceived = 0;
+    m_isChunked = false;
+    m_chunkState = ChunkState::SIZE;
+    m_chunkRemaining = 0;
+    m_bodyConsumer = nullptr;
+    m_pendingLine.clear();
+    m_hasBorrowedViews = false;
+    m_request = HttpRequest();
+    m_body.clear();
+}
+
+HttpRequest HttpParser::takeRequest() {
+    if (!m_body.empty())
+        m_request.adoptBody(std::move(m_body));
+    HttpRequest request = std::move(m_request);
+    reset();
+    return request;
+}
+
+void HttpParser::setHeadCallback(std::function<void(HttpRequest& request)> callback) {
+    m_headCallback = std::move(callback);
+}
+
+void HttpParser::setBodyConsumer(BodyConsumer consumer) {
+    m_bodyConsumer = std::move(consumer);
+}
+
+size_t HttpParser::parseBody(const char* data, size_t length) {
+    size_t piece = std::min(length, m_contentLength - m_bodyReceived);
+    m_bodyReceived += piece;
+    if (m_bodyReceived == m_contentLength)
+        m_state = ParseState::COMPLETE;
+    if (m_bodyConsumer) {
+        m_isPaused = !m_bodyConsumer(std::string_view(data, piece));
+        return piece;
+    }
+    if (m_body.empty() && piece == m_contentLength) {
+        // Whole body arrived in this piece, the request views it in place
+        m_request.setBody(std::string_view(data, piece));
+        return piece;
+    }
+    if (m_body.empty())
+        m_body.reserve(m_contentLength);
+    m_body.append(data, piece);
+    return piece;
+}
+
+size_t HttpParser::parseChunked(const char* data, size_t length) {
+    if (m_chunkState == ChunkState::DATA) {
+        size_t piece = static_cast<size_t>(std::min<uint64_t>(length, m_chunkRemaining));
+        m_chunkRemaining -= piece;
+        if (m_chunkRemaining == 0)
+            m_chunkState = ChunkState::DATA_END;
+        if (m_bodyConsumer)
+            m_isPaused = !m_bodyConsumer(std::string_view(data, piece));
+        else
+            m_body.append(data, piece);
+        return piece;
+    }
+    // Chunk sizes, line ends after chunk data and trailer fields are lines
+    const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', length));
+    size_t lineLength = lineEnd ? static_cast<size_t>(lineEnd - data) : length;
+    if (m_pendingLine.size() + lineLength > m_maxHeaderSize) {
+        fail(HttpStatusCode::BAD_REQUEST);
+        return length;
+    }
+    if (!lineEnd) {
+        m_pendingLine.append(data, length);
+        return length;
+    }
+    std::string_view line(data, lineLength);
+    if (!m_pendingLine.empty()) {
+        m_pendingLine.append(data, lineLength);
+        line = m_pendingLine;
+    }
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    handleChunkLine(line);
+    m_pendingLine.clear();
+    return lineLength + 1;
+}
+
+bool HttpParser::handleChunkLine(std::string_view line) {
+    switch (m_chunkState) {
+    case ChunkState::SIZE: {
+        // Chunk extensions after ';' are ignored (RFC 9112, 7.1.1)
+        std::string_view size = trimWhitespace(line.substr(0, line.find(';')));
+        uint64_t chunkSize = 0;
+        auto [end, error] = std::from_chars(size.data(), size.data() + size.size(), chunkSize, 16);
+        if (size.empty() || error != std::errc() || end != size.data() + size.size()) {
+            debug::log("HttpParser: incorrect chunk size");
+            fail(HttpStatusCode::BAD_REQUEST);
+            return false;
+        }
+        if (!m_bodyConsumer && chunkSize > m_maxBodySize - m_body.size()) {
+            fail(HttpStatusCode::PAYLOAD_TOO_LARGE);
+            return false;
+        }
+        m_chunkRemaining = chunkSize;
+        m_chunkState = chunkSize == 0 ? ChunkState::TRAILER : ChunkState::DATA;
+        return true;
+    }
+    case ChunkState::DATA_END:
+        if (!line.empty()) {
+            fail(HttpStatusCode::BAD_REQUEST);
+            return false;
+        }
+        m_chunkState = ChunkState::SIZE;
+        return true;
+    case ChunkState::TRAILER:
+        if (line.empty()) {
+            m_state = ParseState::COMPLETE;
+            return true;
+        }
+        // Trailer fields count towards the header limit and are dropped
+        m_headerSize += line.size() + 2;
+        if (m_headerSize > m_maxHeaderSize) {
+            fail(HttpStatusCode::REQUEST_HEADER_FIELDS_TOO_LARGE);
+            return false;
+        }
+        return true;
+    case ChunkState::DATA:
+        break;
+    }
+    return true;
+}
+
+size_t HttpParser::parseLines(const char* data, size_t length) {
+    // One pass finds the line end and rejects control characters inside the line.
+    // Carriage return may only come right before the line feed
+    size_t stop = DelimiterScanner::find(data, length, "");
+    bool isLineEnd = false;
+    if (stop < length) {
+        if (data[stop] == '\r' && stop + 1 < length && data[stop + 1] == '\n')
+            ++stop;
+        if (data[stop] == '\n') {
+            isLineEnd = true;
+        } else if (data[stop] != '\r' || stop + 1 != length) {
+            debug::log("HttpParser: control character in request head");
+            fail(HttpStatusCode::BAD_REQUEST);
+            return length;
+        }
+    }
+    if (!m_pendingLine.empty() && m_pendingLine.back() == '\r' && !(isLineEnd && stop == 0)) {
+        fail(HttpStatusCode::BAD_REQUEST);
+        return length;
+    }
+    size_t lineLength = isLineEnd ? stop : length;
+    if (m_headerSize + lineLength > m_maxHeaderSize) {
+        debug::log("HttpParser: header section exceeds ", m_maxHeaderSize, " bytes");
+        fail(m_state == ParseState::REQUEST_LINE ? HttpStatusCode::URI_TOO_LONG
+                                                 : HttpStatusCode::REQUEST_HEADER_FIELDS_TOO_LARGE);
+        return length;
+    }
+    if (!isLineEnd) {
+        // Line continues in the next read
+        m_pendingLine.append(data, length);
+        m_headerSize += length;
+        return length;
+    }
+    m_headerSize += lineLength + 1;
+    std::string_view line(data, lineLength);
+    if (!m_pendingLine.empty()) {
+        m_pendingLine.append(data, lineLength);
+        line = m_pendingLine;
+    }
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    handleLine(line);
+    if (!m_pendingLine.empty()) {
+        // The line is gone once the pending buffer is reused
+        m_request.materialize();
+        m_hasBorrowedViews = false;
+        m_pendingLine.clear();
+    } else {
+        m_hasBorrowedViews = true;
+    }
+    return lineLength + 1;
+}
+
+bool HttpParser::handleLine(std::string_view line) {
+    if (m_state == ParseState::REQUEST_LINE) {
+        // Empty lines before the request line are ignored (RFC 9112, 2.2)
+        if (line.empty())
+            return true;
+        return parseRequestLine(line);
+    }
+    if (line.empty())
+        return finishHeaders();
+    return parseHeaderLine(line);
+}
+
+bool HttpParser::parseRequestLine(std::string_view line) {
+    size_t methodEnd = DelimiterScanner::findTokenEnd(line.data(), line.size());
+    if (methodEnd >= line.size() || line[methodEnd] != ' ') {
+        debug::log("HttpParser: incorrect first line");
+        fail(HttpStatusCode::BAD_REQUEST);
+        return false;
+    }
+    std::string_view target = line.substr(methodEnd + 1);
+    // Path ends at the query or at the target end
+    size_t pathEnd = DelimiterScanner::find(target.data(), target.size(), " ?");
+    size_t targetEnd = pathEnd;
+    if (pathEnd < target.size() && target[pathEnd] == '?')
+        targetEnd = pathEnd + 1 + DelimiterScanner::find(target.data() + pathEnd + 1, target.size() - pathEnd - 1, " ");
+    if (targetEnd >= target.size()) {
+        debug::log("HttpParser: incorrect first line");
+        fail(HttpStatusCode::BAD_REQUEST);
+        return false;
+    }
+    std::string_view method = line.substr(0, methodEnd);
+    std::string_view uri = target.substr(0, pathEnd);
+    std::string_view query;
+    if (pathEnd < targetEnd)
+        query = target.substr(pathEnd + 1, targetEnd - pathEnd - 1);
+    std::string_view version = target.substr(targetEnd + 1);
+    if (method.empty() || uri.empty() || version.substr(0, 5) != "HTTP/") {
+        debug::log("HttpParser: incorrect first line");
+        fail(HttpStatusCode::BAD_REQUEST);
+        return false;
+    }
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+        fail(HttpStatusCode::HTTP_VERSION_NOT_SUPPORTED);
+        return false;
+    }
+    m_request.setMethod(util::stringToHttpMethod(method));
+    if (uri.size() > 1 && uri.back() == '/')
+        uri.remove_suffix(1);
+    m_request.setUri(uri);
+    m_request.setQuery(query);
+    m_request.setVersion(version);
+    m_state = ParseState::HEADERS;
+    return true;
+}
+
+bool HttpParser::parseHeaderLine(std::string_view line) {
+    // Name has to be a token right up to the colon, which rejects whitespace in it
+    // and obsolete line folding as well (RFC 9112, 5.1 and 5.2)
+    size_t colon = DelimiterScanner::findTokenEnd(line.data(), line.size());
+    if (colon == 0 || colon == line.size() || line[colon] != ':') {
+        fail(HttpStatusCode::BAD_REQUEST);
+        return false;
+    }
+    std::string_view name = line.substr(0, colon);
+    std::string_view value = trimWhitespace(line.substr(colon + 1));
+    if (util::equalsIgnoreCase(name, "Content-Length")) {
+        size_t contentLength = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), contentLength);
+        if (error != std::errc() || end != value.data() + value.size() || value.empty() ||
+            (m_hasContentLength && contentLength != m_contentLength)) {
+            fail(HttpStatusCode::BAD_REQUEST);
+            return false;
+        }
+        m_contentLength = contentLength;
+        m_hasContentLength = true;
+    } else if (util::equalsIgnoreCase(name, "Transfer-Encoding")) {
+        // Only chunked is supported, other codings would have to be applied before it
+        if (!util::equalsIgnoreCase(value, "chunked")) {
+            debug::log("HttpParser: Transfer-Encoding ", value, " is not supported");
+            fail(HttpStatusCode::NOT_IMPLEMENTED);
+            return false;
+        }
+        if (m_isChunked) {
+            fail(HttpStatusCode::BAD_REQUEST);
+            return false;
+        }
+        m_isChunked = true;
+    }
+    m_request.addHeader(name, value);
+    return true;
+}
+
+bool HttpParser::finishHeaders() {
+    // Both framings at once are a request smuggling attempt (RFC 9112, 6.3)
+    if (m_isChunked && m_hasContentLength) {
+        fail(HttpStatusCode::BAD_REQUEST);
+        return false;
+    }
+    bool hasBody = m_isChunked || m_contentLength != 0;
+    if (hasBody && m_headCallback)
+        m_headCallback(m_request);
+    if (!m_bodyConsumer && m_contentLength > m_maxBodySize) {
+        fail(HttpStatusCode::PAYLOAD_TOO_LARGE);
+        return false;
+    }
+    m_state = hasBody ? ParseState::BODY : ParseState::COMPLETE;
+    return true;
+}
+
+void HttpParser::fail(HttpStatusCode status) {
+    m_errorStatus = status;
+    m_state = ParseState::FAILED;
+}
+
+}  // namespace ioteye
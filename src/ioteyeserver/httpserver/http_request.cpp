@@ -23,39 +23,218 @@ SOFTWARE.
 */
 
 #include "ioteyeserver/httpserver/http_request.hpp"
+
+#include "ioteyeserver/httpserver/delimiter_scanner.hpp"
+#include "ioteyeserver/utils.hpp"
+
 namespace ioteye {
 
-std::string HttpRequest::getArg(const std::string& arg_name) const {
-    auto it = m_args.find(arg_name);
-    if (it != m_args.end()) {
-        return it->second;
+namespace {
+constexpr std::array<std::string_view, 9> kKnownHeaders = {
+    "Host",          "Connection", "Content-Length", "Content-Type", "Transfer-Encoding",
+    "If-None-Match", "Range",      "If-Range",       "Accept-Encoding"};
+
+uint32_t hashName(std::string_view name) {
+    uint32_t hash = 2166136261u;  // FNV-1a of the lowercase name
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int knownHeaderId(std::string_view name) {
+    for (size_t i = 0; i < kKnownHeaders.size(); ++i) {
+        if (kKnownHeaders[i].size() == name.size() && util::equalsIgnoreCase(kKnownHeaders[i], name))
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+std::string_view trimHeaderValue(std::string_view value) {
+    size_t start = value.find_first_not_of(" \t");
+    if (start == std::string_view::npos)
+        return {};
+    return value.substr(start, value.find_last_not_of(" \t") - start + 1);
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// application/x-www-form-urlencoded decoding, malformed escapes are kept as they are
+void appendPercentDecoded(std::string& out, std::string_view encoded) {
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        char c = encoded[i];
+        if (c == '+') {
+            out += ' ';
+        } else if (c == '%' && i + 2 < encoded.size() && hexValue(encoded[i + 1]) >= 0 &&
+                   hexValue(encoded[i + 2]) >= 0) {
+            out += static_cast<char>(hexValue(encoded[i + 1]) * 16 + hexValue(encoded[i + 2]));
+            i += 2;
+        } else {
+            out += c;
+        }
+    }
+}
+
+bool isEncoded(std::string_view part) {
+    return DelimiterScanner::find(part.data(), part.size(), "%+") < part.size();
+}
+}  // namespace
+
+std::string_view HttpRequest::getArg(std::string_view argName) const {
+    const std::string_view* value = findArg(argName);
+    return value ? *value : std::string_view();
+}
+
+void HttpRequest::setArg(std::string_view argName, std::string_view argValue) {
+    for (auto& [name, value] : m_args) {
+        if (name == argName) {
+            value = argValue;
+            return;
+        }
     }
-    return "";
+    m_args.emplace_back(argName, argValue);
+}
+
+const std::string_view* HttpRequest::findArg(std::string_view argName) const {
+    // Routes have a handful of parameters, a linear search beats hashing the name
+    for (const auto& [name, value] : m_args) {
+        if (name == argName)
+            return &value;
+    }
+    return nullptr;
 }
 
 void HttpRequest::clearArgs() {
     m_args.clear();
 }
 
+std::string_view HttpRequest::getQueryParam(std::string_view name) const {
+    const std::string_view* value = findQueryParam(name);
+    return value ? *value : std::string_view();
+}
+
+bool HttpRequest::hasQueryParam(std::string_view name) const {
+    return findQueryParam(name) != nullptr;
+}
+
+const HttpRequest::Args& HttpRequest::getQueryParams() const {
+    if (!m_isQueryParsed)
+        parseQuery();
+    return m_queryParams;
+}
+
+const std::string_view* HttpRequest::findQueryParam(std::string_view name) const {
+    for (const auto& [paramName, value] : getQueryParams()) {
+        if (paramName == name)
+            return &value;
+    }
+    return nullptr;
+}
+
+void HttpRequest::parseQuery() const {
+    m_isQueryParsed = true;
+    m_queryParams.clear();
+    m_queryStorage.reset();
+    // Usually nothing is escaped, then parameters are plain views into the query
+    std::shared_ptr<std::string> storage;
+    if (isEncoded(m_query)) {
+        storage = std::make_shared<std::string>();
+        // Decoding only shrinks, so the storage is never reallocated
+        storage->reserve(m_query.size());
+    }
+    auto decode = [&storage](std::string_view part) {
+        if (!storage || !isEncoded(part))
+            return part;
+        size_t offset = storage->size();
+        appendPercentDecoded(*storage, part);
+        return std::string_view(storage->data() + offset, storage->size() - offset);
+    };
+    size_t start = 0;
+    while (start < m_query.size()) {
+        size_t end = m_query.find('&', start);
+        if (end == std::string_view::npos)
+            end = m_query.size();
+        std::string_view param = m_query.substr(start, end - start);
+        if (!param.empty()) {
+            size_t equals = param.find('=');
+            std::string_view value = equals == std::string_view::npos ? std::string_view() : param.substr(equals + 1);
+            m_queryParams.emplace_back(decode(param.substr(0, equals)), decode(value));
+        }
+        start = end + 1;
+    }
+    m_queryStorage = std::move(storage);
+}
+
 // Getters
 HttpMethod HttpRequest::getMethod() const {
     return m_method;
 }
 
-const std::string& HttpRequest::getUri() const {
+std::string_view HttpRequest::getUri() const {
     return m_uri;
 }
 
-const std::unordered_map<std::string, std::string>& HttpRequest::getArgs()
-    const {
+std::string_view HttpRequest::getQuery() const {
+    return m_query;
+}
+
+std::string_view HttpRequest::getVersion() const {
+    return m_version;
+}
+
+const HttpRequest::Args& HttpRequest::getArgs() const {
     return m_args;
 }
 
-const std::string& HttpRequest::getHeaders() const {
-    return m_headers;
+std::string HttpRequest::getHeaders() const {
+    std::string headers;
+    for (const auto& field : m_headerFields) {
+        if (!headers.empty())
+            headers += "\r\n";
+        headers.append(field.name.data(), field.name.size());
+        headers += ": ";
+        headers.append(field.value.data(), field.value.size());
+    }
+    return headers;
+}
+
+std::string_view HttpRequest::getHeader(std::string_view name) const {
+    const HeaderField* field = findHeader(name);
+    return field ? field->value : std::string_view();
+}
+
+bool HttpRequest::hasHeader(std::string_view name) const {
+    return findHeader(name) != nullptr;
+}
+
+const HttpRequest::HeaderField* HttpRequest::findHeader(std::string_view name) const {
+    int knownId = knownHeaderId(name);
+    if (knownId >= 0) {
+        uint8_t index = m_knownHeaders[knownId];
+        if (index)
+            return &m_headerFields[index - 1];
+        if (m_headerFields.size() <= UINT8_MAX)
+            return nullptr;
+    }
+    uint32_t nameHash = hashName(name);
+    for (const auto& field : m_headerFields) {
+        if (field.nameHash == nameHash && field.name.size() == name.size() &&
+            util::equalsIgnoreCase(field.name, name))
+            return &field;
+    }
+    return nullptr;
 }
 
-const std::string& HttpRequest::getBody() const {
+std::string_view HttpRequest::getBody() const {
     return m_body;
 }
 
@@ -64,21 +243,94 @@ void HttpRequest::setMethod(HttpMethod method) {
     m_method = method;
 }
 
-void HttpRequest::setUri(const std::string& uri) {
+void HttpRequest::setUri(std::string_view uri) {
     m_uri = uri;
 }
 
-void HttpRequest::setArgs(
-    const std::unordered_map<std::string, std::string>& args) {
-    m_args = args;
+void HttpRequest::setQuery(std::string_view query) {
+    m_query = query;
+    m_isQueryParsed = false;
+}
+
+void HttpRequest::setVersion(std::string_view version) {
+    m_version = version;
+}
+
+void HttpRequest::setArgs(Args args) {
+    m_args = std::move(args);
+}
+
+void HttpRequest::setHeaders(std::string_view headers) {
+    m_headerFields.clear();
+    m_knownHeaders.fill(0);
+    size_t lineStart = 0;
+    while (lineStart < headers.size()) {
+        size_t lineEnd = headers.find("\r\n", lineStart);
+        if (lineEnd == std::string_view::npos)
+            lineEnd = headers.size();
+        size_t colon = headers.find(':', lineStart);
+        if (colon < lineEnd)
+            addHeader(headers.substr(lineStart, colon - lineStart),
+                      trimHeaderValue(headers.substr(colon + 1, lineEnd - colon - 1)));
+        lineStart = lineEnd + 2;
+    }
 }
 
-void HttpRequest::setHeaders(const std::string& headers) {
-    m_headers = headers;
+void HttpRequest::addHeader(std::string_view name, std::string_view value) {
+    m_headerFields.push_back({name, value, hashName(name)});
+    int knownId = knownHeaderId(name);
+    // Slots hold up to 255 fields, later ones are still found through the hash scan
+    if (knownId >= 0 && m_knownHeaders[knownId] == 0 && m_headerFields.size() <= UINT8_MAX)
+        m_knownHeaders[knownId] = static_cast<uint8_t>(m_headerFields.size());
 }
 
-void HttpRequest::setBody(const std::string& body) {
+void HttpRequest::setBody(std::string_view body) {
     m_body = body;
 }
 
+void HttpRequest::adoptBody(std::string body) {
+    m_bodyStorage = std::make_shared<const std::string>(std::move(body));
+    m_body = *m_bodyStorage;
+}
+
+void HttpRequest::materialize() {
+    // Adopted body is owned already and stays where it is
+    bool isBodyOwned = m_bodyStorage && m_body.data() >= m_bodyStorage->data() &&
+                       m_body.data() + m_body.size() <= m_bodyStorage->data() + m_bodyStorage->size();
+    size_t size = m_uri.size() + m_query.size() + m_version.size() + (isBodyOwned ? 0 : m_body.size());
+    for (const auto& [name, value] : m_args)
+        size += name.size() + value.size();
+    for (const auto& field : m_headerFields)
+        size += field.name.size() + field.value.size();
+
+    auto storage = std::make_shared<std::string>();
+    storage->reserve(size);
+    // Never grows past the reserved size, so earlier views stay valid
+    auto copy = [&storage](std::string_view& view) {
+        size_t offset = storage->size();
+        storage->append(view.data(), view.size());
+        view = std::string_view(storage->data() + offset, view.size());
+    };
+    copy(m_uri);
+    copy(m_query);
+    copy(m_version);
+    for (auto& [name, value] : m_args) {
+        copy(name);
+        copy(value);
+    }
+    for (auto& field : m_headerFields) {
+        copy(field.name);
+        copy(field.value);
+    }
+    if (!isBodyOwned) {
+        copy(m_body);
+        m_bodyStorage.reset();
+    }
+    m_storage = std::move(storage);
+    // Parameters are parsed again from the copied query when asked for
+    m_isQueryParsed = false;
+    m_queryParams.clear();
+    m_queryStorage.reset();
+}
+
 }  // namespace ioteye
\ No newline at end of file
@@ -24,15 +24,20 @@ SOFTWARE.
 
 #include "ioteyeserver/httpserver/http_resource.hpp"
 
+#include <charconv>
+#include <cstdint>
+
 namespace ioteye {
 HttpResource::HttpResource(std::shared_ptr<HttpResourceHandler> handler,
                            std::string uri)
     : m_handler(handler), m_uri(uri) {
     m_isValid = createRegexFromURI(uri);
-    m_allowedMethods = {{HttpMethod::HTTP_GET, true},
-                        {HttpMethod::HTTP_POST, true},
-                        {HttpMethod::HTTP_PUT, true},
-                        {HttpMethod::HTTP_DELETE, true}};
+    allowAll();
+}
+
+std::shared_ptr<ResponseCache> HttpResource::enableCache(ResponseCache::Config config) {
+    m_cache = std::make_shared<ResponseCache>(std::move(config));
+    return m_cache;
 }
 
 std::shared_ptr<HttpResponse> HttpResourceHandler::render(
@@ -60,86 +65,133 @@ std::shared_ptr<HttpResponse> HttpResourceHandler::renderDELETE(
     return render(req);
 }
 
+std::shared_ptr<HttpResponse> HttpResourceHandler::renderPATCH(
+    const HttpRequest& req) {
+    debug::log("Default PATCH render called!");
+    return render(req);
+}
+
+std::shared_ptr<BodyConsumer> HttpResourceHandler::consumeBody(
+    const HttpRequest& req) {
+    (void)req;
+    return nullptr;
+}
+
 std::shared_ptr<HttpResponse> HttpResourceHandler::empty_render(
     const HttpRequest& req) {
     (void)req;  // Suppresses unused parameter warning
     return std::make_shared<HttpResponse>();
 }
 
+CannedResponseHandler::CannedResponseHandler(HttpResponse response) : m_response(std::move(response)) {
+}
+
+std::shared_ptr<HttpResponse> CannedResponseHandler::renderGET(const HttpRequest& req) {
+    (void)req;
+    return m_response.get();
+}
+
 void HttpResource::setAllowing(HttpMethod_t httpMethod, bool allowed) {
-    if (m_allowedMethods.empty()) {
-        debug::log("setAllowing: m_allowedMethods is empty!");
+    if (httpMethod <= HttpMethod::UNKNOWN || httpMethod >= HttpMethod::HTTP_METHOD_MAX) {
+        debug::log("setAllowing: Method ", util::httpMethodToString(httpMethod), " not found!");
         return;
     }
-    auto method = m_allowedMethods.find(httpMethod);
-    if (method == m_allowedMethods.end()) {
-        debug::log("setAllowing: Method ", util::httpMethodToString(httpMethod),
-                   " not found!");
-    } else {
-        method->second = allowed;
-        debug::log("setAllowing: Method ", util::httpMethodToString(httpMethod),
-                   " is now allowed: ", allowed ? "True" : "False");
-    }
+    if (allowed)
+        m_allowedMethods |= 1u << httpMethod;
+    else
+        m_allowedMethods &= ~(1u << httpMethod);
+    updateAllowHeader();
+    debug::log("setAllowing: Method ", util::httpMethodToString(httpMethod),
+               " is now allowed: ", allowed ? "True" : "False");
 }
 
 void HttpResource::disallowAll() {
-    for (auto it = m_allowedMethods.begin(); it != m_allowedMethods.end();
-         ++it) {
-        it->second = false;
-    }
+    m_allowedMethods = 0;
+    updateAllowHeader();
     debug::log("disallowAll: all methods are disallowed!");
 }
 
 void HttpResource::allowAll() {
-    for (auto it = m_allowedMethods.begin(); it != m_allowedMethods.end();
-         ++it) {
-        it->second = true;
-    }
+    m_allowedMethods = 0;
+    for (HttpMethod_t method = HttpMethod::UNKNOWN + 1; method < HttpMethod::HTTP_METHOD_MAX; ++method)
+        m_allowedMethods |= 1u << method;
+    updateAllowHeader();
     debug::log("allowAll: all methods are allowed!");
 }
 
-bool HttpResource::isAllowed(HttpMethod_t httpMethod) {
-    if (m_allowedMethods.empty()) {
-        debug::log("isAllowed: m_allowedMethods is empty!");
-        return false;
+std::vector<HttpMethod> HttpResource::getAllowedMethods() const {
+    std::vector<HttpMethod> allowedMethods;
+    for (HttpMethod_t method = HttpMethod::UNKNOWN + 1; method < HttpMethod::HTTP_METHOD_MAX; ++method) {
+        if (isAllowed(method))
+            allowedMethods.push_back(static_cast<HttpMethod>(method));
     }
-    auto method = m_allowedMethods.find(httpMethod);
-    if (method == m_allowedMethods.end()) {
-        return false;
-    } else {
-        return method->second;
+    return allowedMethods;
+}
+
+void HttpResource::updateAllowHeader() {
+    m_allowHeader.clear();
+    for (HttpMethod method : getAllowedMethods()) {
+        if (!m_allowHeader.empty())
+            m_allowHeader += ", ";
+        m_allowHeader += util::httpMethodToString(method);
     }
+    m_methodNotAllowed = std::make_shared<CannedResponse>(*createMethodNotAllowed(m_allowHeader));
+    m_options = std::make_shared<CannedResponse>(*createOptionsResponse(m_allowHeader));
 }
 
-std::string HttpResource::getAllowedMethodsAsString() {
-    std::string allowedMethods;
-    for (auto it = m_allowedMethods.cbegin(); it != m_allowedMethods.end();
-         ++it) {
-        if (!allowedMethods.empty())
-            allowedMethods += ", ";
-        if (it->second) {
-            if (it->first > 0 && it->first < HttpMethod::HTTP_METHOD_MAX)
-                allowedMethods += (util::httpMethodToString(it->first));
-        }
+bool HttpResource::parseParamSpec(std::string_view spec, std::string& name, ParamType& type) {
+    size_t colon = spec.find(':');
+    name = std::string(spec.substr(0, colon));
+    if (colon == std::string_view::npos) {
+        type = ParamType::STRING;
+        return true;
     }
-    return allowedMethods;
+    std::string_view typeName = spec.substr(colon + 1);
+    if (typeName == "int")
+        type = ParamType::INT;
+    else if (typeName == "u64")
+        type = ParamType::U64;
+    else if (typeName == "alnum")
+        type = ParamType::ALNUM;
+    else if (typeName == "path")
+        type = ParamType::PATH;
+    else
+        return false;
+    return true;
 }
 
-std::vector<HttpMethod> HttpResource::getAllowedMethods() {
-    std::vector<HttpMethod> allowedMethods;
-    for (auto it = m_allowedMethods.cbegin(); it != m_allowedMethods.end();
-         ++it) {
-        if (it->second) {
-            if (it->first > 0 && it->first < HttpMethod::HTTP_METHOD_MAX)
-                allowedMethods.push_back(static_cast<HttpMethod>(it->first));
+bool HttpResource::matchesParamType(ParamType type, std::string_view value) {
+    if (value.empty())
+        return false;
+    const char* end = value.data() + value.size();
+    switch (type) {
+        case ParamType::INT: {
+            int64_t number;
+            auto [ptr, ec] = std::from_chars(value.data(), end, number);
+            return ec == std::errc() && ptr == end;
         }
+        case ParamType::U64: {
+            uint64_t number;
+            auto [ptr, ec] = std::from_chars(value.data(), end, number);
+            return ec == std::errc() && ptr == end;
+        }
+        case ParamType::ALNUM:
+            for (char c : value) {
+                if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')))
+                    return false;
+            }
+            return true;
+        case ParamType::STRING:
+        case ParamType::PATH:
+            return true;
     }
-    return allowedMethods;
+    return false;
 }
 
 bool HttpResource::createRegexFromURI(std::string uri) {
     std::string regexPattern = uri;
     m_paramNames.clear();
+    m_paramTypes.clear();
     size_t pos = regexPattern.find("{");
     while (pos != std::string::npos) {
         size_t endPos = regexPattern.find("}", pos);
@@ -149,10 +201,28 @@ bool HttpResource::createRegexFromURI(std::string uri) {
                        "as invalid!");
             return false;
         }
-        std::string paramName = regexPattern.substr(pos + 1, endPos - pos - 1);
+        std::string paramName;
+        ParamType paramType;
+        if (!parseParamSpec(std::string_view(regexPattern).substr(pos + 1, endPos - pos - 1), paramName,
+                            paramType)) {
+            debug::log("Error: Unknown parameter type in route pattern '", uri,
+                       "'. This resource will be marked as invalid!");
+            return false;
+        }
         m_paramNames.push_back(paramName);
-        regexPattern.replace(pos, endPos - pos + 1, "([^/]+)");
-        pos = regexPattern.find("{", pos + 6);
+        m_paramTypes.push_back(paramType);
+        // Ranges of numbers are checked by matchesParamType after the match
+        std::string group = "([^/]+)";
+        if (paramType == ParamType::INT)
+            group = "(-?[0-9]+)";
+        else if (paramType == ParamType::U64)
+            group = "([0-9]+)";
+        else if (paramType == ParamType::ALNUM)
+            group = "([A-Za-z0-9]+)";
+        else if (paramType == ParamType::PATH)
+            group = "(.+)";
+        regexPattern.replace(pos, endPos - pos + 1, group);
+        pos = regexPattern.find("{", pos + group.size());
     }
     m_regexUri = std::regex(regexPattern);
     return true;
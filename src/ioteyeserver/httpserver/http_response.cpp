@@ -24,40 +24,113 @@ SOFTWARE.
 
 #include "ioteyeserver/httpserver/http_response.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+#include "ioteyeserver/httpserver/http_date.hpp"
+#include "ioteyeserver/utils.hpp"
+
 namespace ioteye {
 
-HttpResponse::HttpResponse(int statusCode, const std::string& body,
-                           const std::unordered_map<std::string, std::string>& headers)
-    : m_statusCode(statusCode), m_body(body), m_headers(headers) {
-    if (m_headers.find("Content-Type") == m_headers.end()) {
-        m_headers["Content-Type"] = "text/plain";
+HttpResponse::HttpResponse(int statusCode, const std::string& body, Headers headers)
+    : m_statusCode(statusCode), m_body(body), m_headers(std::move(headers)) {
+    if (!findHeader("Content-Type"))
+        m_headers.emplace_back("Content-Type", "text/plain");
+}
+
+std::pair<std::string, std::string>* HttpResponse::findHeader(std::string_view key) {
+    for (auto& header : m_headers) {
+        if (util::equalsIgnoreCase(header.first, key))
+            return &header;
     }
+    return nullptr;
 }
 
-std::string HttpResponse::toString() const {
-    std::stringstream ss;
-    ss << "HTTP/1.1 " << m_statusCode << " " << util::getStatusMessage(m_statusCode) << "\r\n";
-    for (const auto& pair : m_headers) {
-        ss << pair.first << ": " << pair.second << "\r\n";
+std::string HttpResponse::serializeHead(std::string_view connection) const {
+    std::string_view statusLine = util::getStatusLine(m_statusCode);
+    std::string customStatusLine;
+    if (statusLine.empty()) {
+        customStatusLine = "HTTP/1.1 " + std::to_string(m_statusCode) + ' ' +
+                           util::getStatusMessage(m_statusCode) + "\r\n";
+        statusLine = customStatusLine;
     }
-    if (!m_body.empty()) {
-        ss << "Content-Length: " << m_body.size() << "\r\n";
-        ss << "\r\n";
-        ss << m_body;
-    } else {
-        ss << "\r\n";
+    std::string_view date = HttpDate::now();
+    size_t size = statusLine.size() + date.size() + connection.size() + 64;
+    bool hasDate = false;
+    for (const auto& [key, value] : m_headers) {
+        size += key.size() + value.size() + 4;
+        hasDate = hasDate || util::equalsIgnoreCase(key, "Date");
     }
-    return ss.str();
+    std::string head;
+    head.reserve(size);
+    head += statusLine;
+    if (!hasDate) {
+        head += "Date: ";
+        head += date;
+        head += "\r\n";
+    }
+    for (const auto& [key, value] : m_headers) {
+        if (!connection.empty() && util::equalsIgnoreCase(key, "Connection"))
+            continue;
+        head += key;
+        head += ": ";
+        head += value;
+        head += "\r\n";
+    }
+    if (!connection.empty()) {
+        head += "Connection: ";
+        head += connection;
+        head += "\r\n";
+    }
+    // Every answer which may have a body states its length, even an empty one, otherwise a
+    // keep-alive client can't tell where it ends (RFC 9112, 6.3)
+    bool mayHaveBody = m_statusCode >= 200 && m_statusCode != HttpStatusCode::NO_CONTENT &&
+                       m_statusCode != HttpStatusCode::NOT_MODIFIED;
+    uint64_t bodySize = getBodySize();
+    if (m_generator) {
+        head += "Transfer-Encoding: chunked\r\n";
+    } else if (mayHaveBody) {
+        char length[24];
+        auto result = std::to_chars(length, length + sizeof(length), bodySize);
+        head += "Content-Length: ";
+        head.append(length, result.ptr);
+        head += "\r\n";
+    }
+    head += "\r\n";
+    return head;
+}
+
+std::string HttpResponse::toString() const {
+    std::string head = m_isCanned ? m_head : serializeHead();
+    if (m_isHeadOnly)
+        return head;
+    head += m_file ? getBody() : getBodyView();
+    return head;
+}
+
+std::array<asio::const_buffer, 2> HttpResponse::toBuffers(std::string& head, std::string_view connection) const {
+    bool isSerialized = m_isCanned && connection.empty();
+    if (!isSerialized)
+        head = serializeHead(connection);
+    const std::string& serialized = isSerialized ? m_head : head;
+    if (m_isHeadOnly)
+        return {asio::buffer(serialized), asio::const_buffer()};
+    std::string_view body = getBodyView();
+    return {asio::buffer(serialized), asio::buffer(body.data(), body.size())};
 }
 
 void HttpResponse::setHeader(const std::string& key, const std::string& value) {
-    m_headers[key] = value;
+    if (auto* header = findHeader(key))
+        header->second = value;
+    else
+        m_headers.emplace_back(key, value);
 }
 
-std::string HttpResponse::getHeader(const std::string& key) const {
-    auto it = m_headers.find(key);
-    if (it != m_headers.end()) {
-        return it->second;
+std::string HttpResponse::getHeader(std::string_view key) const {
+    for (const auto& header : m_headers) {
+        if (util::equalsIgnoreCase(header.first, key))
+            return header.second;
     }
     return "";
 }
@@ -67,14 +140,62 @@ int HttpResponse::getStatusCode() const {
 }
 
 void HttpResponse::setContentType(const std::string& contentType) {
-    m_headers["Content-Type"] = contentType;
+    setHeader("Content-Type", contentType);
 }
 
 void HttpResponse::setBody(const std::string& body) {
     m_body = body;
+    m_bodyOwner.reset();
+    m_sharedBody = std::string_view();
+    m_file.reset();
+    m_generator = nullptr;
+    m_notifier.reset();
+}
+
+void HttpResponse::setSharedBody(std::string_view body, std::shared_ptr<const void> owner) {
+    m_body.clear();
+    m_bodyOwner = std::move(owner);
+    m_sharedBody = body;
+    m_file.reset();
+    m_generator = nullptr;
+    m_notifier.reset();
+}
+
+void HttpResponse::setFileBody(std::shared_ptr<const FileBody> file) {
+    m_body.clear();
+    m_bodyOwner.reset();
+    m_sharedBody = std::string_view();
+    m_fileOffset = 0;
+    m_fileLength = file ? file->getSize() : 0;
+    m_file = std::move(file);
+    m_generator = nullptr;
+    m_notifier.reset();
+    setHeader("Accept-Ranges", "bytes");
+}
+
+void HttpResponse::setBodyGenerator(BodyGenerator generator, std::shared_ptr<BodyNotifier> notifier) {
+    setBody("");
+    m_generator = std::move(generator);
+    m_notifier = std::move(notifier);
+}
+
+void HttpResponse::setBodyRange(uint64_t offset, uint64_t length) {
+    uint64_t size = getBodySize();
+    offset = std::min(offset, size);
+    length = std::min(length, size - offset);
+    if (m_file) {
+        m_fileOffset += offset;
+        m_fileLength = length;
+    } else if (m_bodyOwner) {
+        m_sharedBody = m_sharedBody.substr(offset, length);
+    } else {
+        m_body = m_body.substr(offset, length);
+    }
 }
 
 void HttpResponse::addBody(const std::string& body) {
+    if (m_bodyOwner || m_file || m_generator)
+        setBody(getBody());
     m_body += body;
 }
 
@@ -82,29 +203,119 @@ void HttpResponse::setStatusCode(int statusCode) {
     m_statusCode = statusCode;
 }
 
+void HttpResponse::setHeadOnly(bool headOnly) {
+    m_isHeadOnly = headOnly;
+}
+
+bool HttpResponse::isHeadOnly() const {
+    return m_isHeadOnly;
+}
+
 std::string HttpResponse::getBody() const {
-    return m_body;
+    if (!m_file)
+        return std::string(getBodyView());
+    std::string body(m_fileLength, '\0');
+    long long count = m_file->read(m_fileOffset, body.data(), body.size());
+    body.resize(count > 0 ? static_cast<size_t>(count) : 0);
+    return body;
+}
+
+CannedResponse::CannedResponse(HttpResponse response) : m_response(std::move(response)) {
+    m_response.m_variants = std::make_shared<CompressedVariants>();
+}
+
+std::shared_ptr<HttpResponse> CannedResponse::get() const {
+    std::time_t now = HttpDate::currentTime();
+    if (m_currentTime.load(std::memory_order_acquire) != now) {
+        // Threads which meet the new second together may all rebuild, any of the results will do
+        auto response = std::make_shared<HttpResponse>(m_response);
+        response->m_head = response->serializeHead();
+        response->m_isCanned = true;
+        std::atomic_store(&m_current, std::shared_ptr<HttpResponse>(std::move(response)));
+        m_currentTime.store(now, std::memory_order_release);
+    }
+    return std::atomic_load(&m_current);
+}
+
+std::shared_ptr<HttpResponse> makeMutable(std::shared_ptr<HttpResponse> response) {
+    if (!response)
+        return response;
+    auto copy = std::make_shared<HttpResponse>(*response);
+    copy->m_isCanned = false;
+    // Variants were compressed from the unchanged body
+    copy->m_variants.reset();
+    return copy;
+}
+
+std::shared_ptr<HttpResponse> loadBody(std::shared_ptr<HttpResponse> response) {
+    if (!response)
+        return response;
+    if (response->getBodyGenerator()) {
+        // Even a HEAD answer needs the length of the body
+        auto loaded = makeMutable(std::move(response));
+        std::string body;
+        std::string chunk;
+        try {
+            for (bool hasMore = true; hasMore; body += chunk) {
+                chunk.clear();
+                hasMore = loaded->getBodyGenerator()(chunk);
+                // Nothing waits for the notifier here, asking again would spin
+                if (chunk.empty() && hasMore)
+                    throw std::runtime_error("generator has no data ready");
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "loadBody: Exception in body generator: " << e.what() << std::endl;
+            return createErrorResponse(HttpStatusCode::INTERNAL_SERVER_ERROR);
+        }
+        loaded->setBody(body);
+        return loaded;
+    }
+    if (!response->getFileBody() || response->isHeadOnly())
+        return response;
+    auto loaded = makeMutable(std::move(response));
+    loaded->setBody(loaded->getBody());
+    return loaded;
 }
 
 std::shared_ptr<HttpResponse> createBadRequestResponse() {
-    auto response = std::make_shared<HttpResponse>(HttpStatusCode::BAD_REQUEST, "Bad Request");
-    return response;
+    return createErrorResponse(HttpStatusCode::BAD_REQUEST);
 }
 std::shared_ptr<HttpResponse> createNotFoundResponse() {
-    auto response = std::make_shared<HttpResponse>(HttpStatusCode::NOT_FOUND, "Not Found");
-    return response;
+    return createErrorResponse(HttpStatusCode::NOT_FOUND);
 }
 std::shared_ptr<HttpResponse> createMethodNotAllowed(const std::string& allowedMethods) {
     auto response = std::make_shared<HttpResponse>(HttpStatusCode::METHOD_NOT_ALLOWED, "Method not allowed");
     response->setHeader("Allow", allowedMethods);
     return response;
 }
+std::shared_ptr<HttpResponse> createOptionsResponse(const std::string& allowedMethods) {
+    auto response = std::make_shared<HttpResponse>(HttpStatusCode::NO_CONTENT);
+    response->setHeader("Allow", allowedMethods);
+    return response;
+}
+std::shared_ptr<HttpResponse> createErrorResponse(int statusCode) {
+    // Every 4xx and 5xx status with a reason phrase, canned on first use
+    static const auto cannedErrors = []() {
+        std::array<std::unique_ptr<CannedResponse>, 200> responses;
+        for (int code = 400; code < 600; ++code) {
+            if (!util::getStatusLine(code).empty())
+                responses[code - 400] =
+                    std::make_unique<CannedResponse>(HttpResponse(code, util::getStatusMessage(code)));
+        }
+        return responses;
+    }();
+    if (statusCode >= 400 && statusCode < 600 && cannedErrors[statusCode - 400])
+        return cannedErrors[statusCode - 400]->get();
+    return std::make_shared<HttpResponse>(statusCode, util::getStatusMessage(statusCode));
+}
 
-void sendUdpResponse(const HttpResponse& response, std::shared_ptr<asio::ip::udp::socket> socket,
-                     asio::ip::udp::endpoint& destination) {
-    debug::log(response.toString());
-    socket->async_send_to(asio::buffer(response.toString()), destination,
-                          [](const asio::error_code& error, std::size_t bytesTransfered) {
+void sendUdpResponse(std::shared_ptr<HttpResponse> response, std::shared_ptr<asio::ip::udp::socket> socket,
+                     const asio::ip::udp::endpoint& destination) {
+    // Handler keeps the response and its head alive, the datagram is gathered from their storage
+    response = loadBody(std::move(response));
+    auto head = std::make_shared<std::string>();
+    socket->async_send_to(response->toBuffers(*head), destination,
+                          [response, head](const asio::error_code& error, std::size_t bytesTransfered) {
                               if (!error) {
                                   debug::log("[UDP] Response sent successfully. BytesTransfered: ",
                                              bytesTransfered);
@@ -114,16 +325,20 @@ void sendUdpResponse(const HttpResponse& response, std::shared_ptr<asio::ip::udp
                           });
 }
 
-void sendTcpResponse(const HttpResponse& response, std::shared_ptr<asio::ip::tcp::socket> socket) {
-    debug::log(response.toString());
-    asio::async_write(*socket, asio::buffer(response.toString()),
-                      [socket](const asio::error_code& error, std::size_t bytesTransfered) {
+void sendTcpResponse(std::shared_ptr<HttpResponse> response, std::shared_ptr<asio::ip::tcp::socket> socket,
+                     std::function<void(const asio::error_code&)> onSent) {
+    response = loadBody(std::move(response));
+    auto head = std::make_shared<std::string>();
+    asio::async_write(*socket, response->toBuffers(*head),
+                      [socket, response, head, onSent](const asio::error_code& error, std::size_t bytesTransfered) {
                           if (!error) {
                               debug::log("[TCP] Response sent successfully. BytesTransfered: ",
                                          bytesTransfered);
                           } else {
                               debug::log("[TCP] Error sending response: ", error.message());
                           }
+                          if (onSent)
+                              onSent(error);
                       });
 }
 }  // namespace ioteye
\ No newline at end of file
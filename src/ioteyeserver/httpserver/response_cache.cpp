@@ -0,0 +1,208 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/response_cache.hpp"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+#include "ioteyeserver/http_status_codes.hpp"
+#include "ioteyeserver/logging.hpp"
+
+namespace ioteye {
+namespace {
+// Headers a 304 repeats from the 200 it stands for (RFC 9110, 15.4.5)
+constexpr std::array<std::string_view, 5> kNotModifiedHeaders = {"Content-Type", "Cache-Control", "Expires",
+                                                                 "Vary", "Content-Location"};
+
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.remove_suffix(1);
+    return value;
+}
+
+std::string_view withoutWeakPrefix(std::string_view etag) {
+    if (etag.size() >= 2 && etag[0] == 'W' && etag[1] == '/')
+        etag.remove_prefix(2);
+    return etag;
+}
+
+HttpResponse makeNotModified(const HttpResponse& response, const std::string& etag) {
+    HttpResponse notModified(HttpStatusCode::NOT_MODIFIED);
+    notModified.setHeader("ETag", etag);
+    for (std::string_view name : kNotModifiedHeaders) {
+        std::string value = response.getHeader(name);
+        if (!value.empty())
+            notModified.setHeader(std::string(name), value);
+    }
+    return notModified;
+}
+}  // namespace
+
+ResponseCache::Entry::Entry(const HttpResponse& response, const HttpResponse& notModified)
+    : response(response), notModified(notModified) {
+}
+
+ResponseCache::ResponseCache(Config config) : m_config(std::move(config)) {
+}
+
+std::shared_ptr<HttpResponse> ResponseCache::respond(const HttpRequest& request,
+                                                     const std::function<std::shared_ptr<HttpResponse>()>& render) {
+    auto now = std::chrono::steady_clock::now();
+    std::string key = makeKey(request);
+    std::shared_ptr<const Entry> entry = find(key, now);
+    if (entry) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        auto response = render();
+        // Generated bodies are produced while they are sent, there is nothing to store
+        if (!response || response->getStatusCode() != HttpStatusCode::OK || response->getBodyGenerator())
+            return response;
+        entry = store(std::move(key), *response, now);
+    }
+    if (matchesIfNoneMatch(request.getHeader("If-None-Match"), entry->etag)) {
+        m_notModified.fetch_add(1, std::memory_order_relaxed);
+        return entry->notModified.get();
+    }
+    return entry->response.get();
+}
+
+void ResponseCache::invalidate() {
+    std::unique_lock lock(m_mutex);
+    m_entries.clear();
+}
+
+void ResponseCache::invalidate(std::string_view path) {
+    std::unique_lock lock(m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        std::string_view key = it->first;
+        // Key is the path followed by '\0' separated values
+        if (key.substr(0, path.size()) == path && (key.size() == path.size() || key[path.size()] == '\0'))
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+size_t ResponseCache::size() const {
+    std::shared_lock lock(m_mutex);
+    return m_entries.size();
+}
+
+ResponseCache::Stats ResponseCache::getStats() const {
+    Stats stats;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.notModified = m_notModified.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string ResponseCache::makeETag(std::string_view body) {
+    // FNV-1a, the tag only has to change when the body does
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : body) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::string etag(18, '"');
+    for (int i = 16; i >= 1; --i, hash >>= 4)
+        etag[i] = kHex[hash & 0xf];
+    return etag;
+}
+
+bool ResponseCache::matchesIfNoneMatch(std::string_view ifNoneMatch, std::string_view etag) {
+    ifNoneMatch = trim(ifNoneMatch);
+    if (ifNoneMatch.empty() || etag.empty())
+        return false;
+    if (ifNoneMatch == "*")
+        return true;
+    etag = withoutWeakPrefix(etag);
+    while (!ifNoneMatch.empty()) {
+        size_t comma = ifNoneMatch.find(',');
+        if (withoutWeakPrefix(trim(ifNoneMatch.substr(0, comma))) == etag)
+            return true;
+        if (comma == std::string_view::npos)
+            break;
+        ifNoneMatch.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+std::string ResponseCache::makeKey(const HttpRequest& request) const {
+    std::string key(request.getUri());
+    for (const auto& name : m_config.keyArgs) {
+        key += '\0';
+        std::string_view value = request.getArg(name);
+        key += value.empty() ? request.getQueryParam(name) : value;
+    }
+    for (const auto& name : m_config.keyHeaders) {
+        key += '\0';
+        key += request.getHeader(name);
+    }
+    return key;
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::find(const std::string& key,
+                                                                std::chrono::steady_clock::time_point now) const {
+    std::shared_lock lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || it->second->expires <= now)
+        return nullptr;
+    return it->second;
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::store(std::string key, const HttpResponse& response,
+                                                                 std::chrono::steady_clock::time_point now) {
+    HttpResponse cached(response);
+    std::string etag = cached.getHeader("ETag");
+    if (etag.empty()) {
+        etag = makeETag(cached.getBody());
+        cached.setHeader("ETag", etag);
+    }
+    auto entry = std::make_shared<Entry>(cached, makeNotModified(cached, etag));
+    entry->expires = now + m_config.ttl;
+    entry->etag = std::move(etag);
+
+    std::unique_lock lock(m_mutex);
+    if (m_entries.size() >= m_config.maxEntries && !m_entries.count(key)) {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->second->expires <= now)
+                it = m_entries.erase(it);
+            else
+                ++it;
+        }
+        if (m_entries.size() >= m_config.maxEntries) {
+            debug::log("ResponseCache: full, evicting an entry");
+            m_entries.erase(m_entries.begin());
+        }
+    }
+    m_entries[std::move(key)] = entry;
+    return entry;
+}
+}  // namespace ioteye
@@ -0,0 +1,390 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/router.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <regex>
+#include <unordered_set>
+
+namespace ioteye {
+
+struct Router::Node {
+    // Static segments joined by '/', empty for the root and parameter nodes
+    std::string label;
+    std::string firstSegment;
+    // Static children have distinct first segments and are sorted by them
+    std::vector<std::unique_ptr<Node>> children;
+    // Parameter children, sorted by paramPrecedence of their types
+    std::vector<std::unique_ptr<Node>> params;
+    std::string paramName;
+    ParamType paramType = ParamType::STRING;
+    std::shared_ptr<HttpResource> resource;
+};
+
+namespace {
+std::vector<std::string> splitSegments(std::string_view path) {
+    std::vector<std::string> segments;
+    size_t start = 0;
+    while (true) {
+        size_t end = path.find('/', start);
+        if (end == std::string_view::npos) {
+            segments.emplace_back(path.substr(start));
+            return segments;
+        }
+        segments.emplace_back(path.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+std::string joinSegments(const std::vector<std::string>& segments, size_t begin, size_t end) {
+    std::string joined;
+    for (size_t i = begin; i < end; ++i) {
+        if (i != begin)
+            joined += '/';
+        joined += segments[i];
+    }
+    return joined;
+}
+
+bool isParamSegment(const std::string& segment) {
+    return segment.size() > 2 && segment.front() == '{' && segment.back() == '}' &&
+           segment.find_first_of("{}", 1) == segment.size() - 1;
+}
+
+int paramPrecedence(ParamType type) {
+    switch (type) {
+        case ParamType::INT:
+            return 0;
+        case ParamType::U64:
+            return 1;
+        case ParamType::ALNUM:
+            return 2;
+        case ParamType::STRING:
+            return 3;
+        case ParamType::PATH:
+            break;
+    }
+    return 4;
+}
+
+bool hasBraces(const std::string& segment) {
+    return segment.find_first_of("{}") != std::string::npos;
+}
+
+uint64_t hashUri(std::string_view uri) {
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a
+    for (char c : uri) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t slotOf(uint64_t hash, uint32_t seed, size_t tableSize) {
+    uint64_t mixed = hash ^ (seed * 0x9e3779b97f4a7c15ull);  // splitmix64 finalizer
+    mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<size_t>((mixed ^ (mixed >> 31)) % tableSize);
+}
+
+constexpr uint32_t kMaxSeed = 1u << 16;
+
+// Consumes the first segment of rest
+std::string_view takeSegment(std::string_view& rest, bool& isDone) {
+    size_t slash = rest.find('/');
+    std::string_view segment = rest.substr(0, slash);
+    if (slash == std::string_view::npos) {
+        isDone = true;
+        rest = std::string_view();
+    } else {
+        rest.remove_prefix(slash + 1);
+    }
+    return segment;
+}
+}  // namespace
+
+Router::Router() : m_root(std::make_unique<Node>()) {}
+
+Router::~Router() = default;
+
+Router::Router(Router&& other) noexcept = default;
+
+Router& Router::operator=(Router&& other) noexcept = default;
+
+void Router::addResource(std::shared_ptr<HttpResource> resource) {
+    if (!resource || !resource->getIsValid())
+        return;
+    const std::string& uri = resource->getUri();
+    bool isTreeRoute = !uri.empty() && uri.front() == '/';
+    std::vector<std::string> segments = isTreeRoute ? splitSegments(std::string_view(uri).substr(1))
+                                                    : std::vector<std::string>();
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (hasBraces(segments[i]) && !isParamSegment(segments[i]))
+            isTreeRoute = false;
+        // Rest of the uri can only be taken by the last segment
+        if (i + 1 < segments.size() && segments[i].size() > 6 &&
+            segments[i].compare(segments[i].size() - 6, 6, ":path}") == 0)
+            isTreeRoute = false;
+    }
+    if (!isTreeRoute) {
+        m_regexResources.push_back(std::move(resource));
+        return;
+    }
+    if (!hasBraces(uri))
+        m_staticResources.push_back(resource);
+    insert(*m_root, segments, 0, std::move(resource));
+}
+
+void Router::build() {
+    // Resources come from an unordered map, their order of addition means nothing
+    std::stable_sort(m_regexResources.begin(), m_regexResources.end(),
+                     [](const std::shared_ptr<HttpResource>& lhs, const std::shared_ptr<HttpResource>& rhs) {
+                         return lhs->getUri() < rhs->getUri();
+                     });
+
+    // Later resource with the same uri replaces the earlier one, as in the tree
+    std::vector<StaticRoute> routes;
+    std::unordered_set<std::string_view> seen;
+    for (auto it = m_staticResources.rbegin(); it != m_staticResources.rend(); ++it) {
+        if (seen.insert((*it)->getUri()).second)
+            routes.push_back({(*it)->getUri(), *it});
+    }
+    m_staticSeeds.clear();
+    m_staticTable.clear();
+    if (routes.empty())
+        return;
+
+    std::vector<uint64_t> hashes(routes.size());
+    for (size_t i = 0; i < routes.size(); ++i)
+        hashes[i] = hashUri(routes[i].uri);
+    size_t bucketCount = routes.size() / 2 + 1;
+    std::vector<std::vector<size_t>> buckets(bucketCount);
+    for (size_t i = 0; i < routes.size(); ++i)
+        buckets[hashes[i] % bucketCount].push_back(i);
+    // Largest buckets are placed first, while the table is still empty
+    std::vector<size_t> order(bucketCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](size_t lhs, size_t rhs) { return buckets[lhs].size() > buckets[rhs].size(); });
+
+    for (size_t tableSize = routes.size() + routes.size() / 4 + 1;; tableSize *= 2) {
+        std::vector<uint32_t> seeds(bucketCount, 0);
+        std::vector<bool> isTaken(tableSize, false);
+        std::vector<size_t> slots;
+        bool isPlaced = true;
+        for (size_t bucket : order) {
+            if (buckets[bucket].empty())
+                break;
+            uint32_t seed = 1;
+            for (; seed < kMaxSeed; ++seed) {
+                slots.clear();
+                for (size_t route : buckets[bucket]) {
+                    size_t slot = slotOf(hashes[route], seed, tableSize);
+                    if (isTaken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                        break;
+                    slots.push_back(slot);
+                }
+                if (slots.size() == buckets[bucket].size())
+                    break;
+            }
+            if (seed == kMaxSeed) {
+                isPlaced = false;
+                break;
+            }
+            seeds[bucket] = seed;
+            for (size_t slot : slots)
+                isTaken[slot] = true;
+        }
+        if (!isPlaced)
+            continue;
+
+        m_staticTable.resize(tableSize);
+        for (size_t i = 0; i < routes.size(); ++i) {
+            size_t slot = slotOf(hashes[i], seeds[hashes[i] % bucketCount], tableSize);
+            m_staticTable[slot] = std::move(routes[i]);
+        }
+        m_staticSeeds = std::move(seeds);
+        debug::log("Router: ", m_staticTable.size(), " slots for ", routes.size(), " static routes");
+        return;
+    }
+}
+
+void Router::insert(Node& node, const std::vector<std::string>& segments, size_t index,
+                    std::shared_ptr<HttpResource> resource) {
+    if (index == segments.size()) {
+        node.resource = std::move(resource);
+        return;
+    }
+    if (isParamSegment(segments[index])) {
+        std::string paramName;
+        ParamType paramType;
+        HttpResource::parseParamSpec(std::string_view(segments[index]).substr(1, segments[index].size() - 2),
+                                     paramName, paramType);
+        auto paramIt = std::find_if(node.params.begin(), node.params.end(),
+                                    [paramType](const std::unique_ptr<Node>& param) {
+                                        return param->paramType == paramType;
+                                    });
+        if (paramIt == node.params.end()) {
+            auto param = std::make_unique<Node>();
+            param->paramName = paramName;
+            param->paramType = paramType;
+            paramIt = std::upper_bound(node.params.begin(), node.params.end(), param,
+                                       [](const std::unique_ptr<Node>& lhs, const std::unique_ptr<Node>& rhs) {
+                                           return paramPrecedence(lhs->paramType) < paramPrecedence(rhs->paramType);
+                                       });
+            paramIt = node.params.insert(paramIt, std::move(param));
+        } else if ((*paramIt)->paramName != paramName) {
+            // Same shape with another parameter name can only be told apart by regex
+            m_regexResources.push_back(std::move(resource));
+            return;
+        }
+        insert(**paramIt, segments, index + 1, std::move(resource));
+        return;
+    }
+
+    size_t runEnd = index;
+    while (runEnd < segments.size() && !isParamSegment(segments[runEnd]))
+        ++runEnd;
+    auto childIt = std::lower_bound(
+        node.children.begin(), node.children.end(), segments[index],
+        [](const std::unique_ptr<Node>& child, const std::string& segment) { return child->firstSegment < segment; });
+    if (childIt == node.children.end() || (*childIt)->firstSegment != segments[index]) {
+        auto child = std::make_unique<Node>();
+        child->label = joinSegments(segments, index, runEnd);
+        child->firstSegment = segments[index];
+        Node& inserted = **node.children.insert(childIt, std::move(child));
+        insert(inserted, segments, runEnd, std::move(resource));
+        return;
+    }
+
+    std::vector<std::string> labelSegments = splitSegments((*childIt)->label);
+    size_t common = 0;
+    while (common < labelSegments.size() && index + common < runEnd &&
+           labelSegments[common] == segments[index + common])
+        ++common;
+    if (common < labelSegments.size()) {
+        // Split the edge at the first differing segment
+        auto split = std::make_unique<Node>();
+        split->label = joinSegments(labelSegments, 0, common);
+        split->firstSegment = labelSegments[0];
+        std::unique_ptr<Node> tail = std::move(*childIt);
+        tail->label = joinSegments(labelSegments, common, labelSegments.size());
+        tail->firstSegment = labelSegments[common];
+        split->children.push_back(std::move(tail));
+        *childIt = std::move(split);
+    }
+    insert(**childIt, segments, index + common, std::move(resource));
+}
+
+bool Router::match(std::string_view uri, Match& match) const {
+    match.resource.reset();
+    match.args.clear();
+    if (!m_staticSeeds.empty()) {
+        uint64_t hash = hashUri(uri);
+        uint32_t seed = m_staticSeeds[hash % m_staticSeeds.size()];
+        const StaticRoute& route = m_staticTable[slotOf(hash, seed, m_staticTable.size())];
+        if (route.resource && route.uri == uri) {
+            match.resource = route.resource;
+            return true;
+        }
+    }
+    if (!uri.empty() && uri.front() == '/' && matchNode(*m_root, uri.substr(1), false, match))
+        return true;
+
+    for (const auto& resource : m_regexResources) {
+        std::cmatch matches;
+        if (!std::regex_match(uri.data(), uri.data() + uri.size(), matches, resource->getRegexUri()))
+            continue;
+        const auto& paramNames = resource->getParamNames();
+        const auto& paramTypes = resource->getParamTypes();
+        bool isTypeMatched = true;
+        for (size_t i = 1; i < matches.size() && i <= paramNames.size(); ++i) {
+            std::string_view value(matches[i].first, matches[i].length());
+            isTypeMatched = isTypeMatched && HttpResource::matchesParamType(paramTypes[i - 1], value);
+            match.args.emplace_back(paramNames[i - 1], value);
+        }
+        if (isTypeMatched) {
+            match.resource = resource;
+            return true;
+        }
+        match.args.clear();
+    }
+    return false;
+}
+
+bool Router::matchNode(const Node& node, std::string_view rest, bool isDone, Match& match) {
+    if (isDone) {
+        if (!node.resource)
+            return false;
+        match.resource = node.resource;
+        return true;
+    }
+
+    size_t slash = rest.find('/');
+    std::string_view firstSegment = rest.substr(0, slash);
+    auto childIt = std::lower_bound(
+        node.children.begin(), node.children.end(), firstSegment,
+        [](const std::unique_ptr<Node>& child, std::string_view segment) { return child->firstSegment < segment; });
+    if (childIt != node.children.end() && (*childIt)->firstSegment == firstSegment) {
+        const Node& child = **childIt;
+        std::string_view label = child.label;
+        if (rest.substr(0, label.size()) == label) {
+            if (rest.size() == label.size()) {
+                if (matchNode(child, std::string_view(), true, match))
+                    return true;
+            } else if (rest[label.size()] == '/') {
+                if (matchNode(child, rest.substr(label.size() + 1), false, match))
+                    return true;
+            }
+        }
+    }
+
+    if (node.params.empty())
+        return false;
+    std::string_view wholeRest = rest;
+    bool isParamDone = false;
+    std::string_view segment = takeSegment(rest, isParamDone);
+    if (segment.empty())
+        return false;
+    for (const auto& param : node.params) {
+        if (param->paramType == ParamType::PATH) {
+            match.args.emplace_back(param->paramName, wholeRest);
+            if (matchNode(*param, std::string_view(), true, match))
+                return true;
+            match.args.pop_back();
+            continue;
+        }
+        if (!HttpResource::matchesParamType(param->paramType, segment))
+            continue;
+        match.args.emplace_back(param->paramName, segment);
+        if (matchNode(*param, rest, isParamDone, match))
+            return true;
+        match.args.pop_back();
+    }
+    return false;
+}
+
+}  // namespace ioteye
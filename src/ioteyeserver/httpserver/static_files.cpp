@@ -0,0 +1,306 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/static_files.hpp"
+
+#include <sys/stat.h>
+
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <mutex>
+#include <utility>
+
+#include "ioteyeserver/http_status_codes.hpp"
+#include "ioteyeserver/httpserver/file_body.hpp"
+#include "ioteyeserver/httpserver/http_date.hpp"
+#include "ioteyeserver/httpserver/response_cache.hpp"
+#include "ioteyeserver/logging.hpp"
+#include "ioteyeserver/utils.hpp"
+
+namespace ioteye {
+namespace {
+constexpr std::array<std::pair<std::string_view, std::string_view>, 20> kMimeTypes = {{
+    {"html", "text/html; charset=utf-8"},
+    {"htm", "text/html; charset=utf-8"},
+    {"css", "text/css; charset=utf-8"},
+    {"js", "application/javascript"},
+    {"mjs", "application/javascript"},
+    {"json", "application/json"},
+    {"map", "application/json"},
+    {"txt", "text/plain; charset=utf-8"},
+    {"csv", "text/csv; charset=utf-8"},
+    {"xml", "application/xml"},
+    {"svg", "image/svg+xml"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"ico", "image/x-icon"},
+    {"webp", "image/webp"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"wasm", "application/wasm"},
+}};
+
+int64_t steadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+void appendHex(std::string& out, uint64_t value) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value, 16);
+    out.append(digits, result.ptr);
+}
+
+// Whole file in memory, owner of the bytes is returned and body views them
+std::shared_ptr<const void> readFile(const std::string& filePath, uint64_t size, std::string_view& body) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file)
+        return nullptr;
+    auto content = std::make_shared<std::string>(size, '\0');
+    file.read(content->data(), static_cast<std::streamsize>(size));
+    content->resize(static_cast<size_t>(file.gcount()));
+    body = *content;
+    return content;
+}
+
+}  // namespace
+
+StaticFileHandler::Entry::Entry(const HttpResponse& response, const HttpResponse& notModified)
+    : response(response), notModified(notModified) {
+}
+
+StaticFileHandler::StaticFileHandler(std::string directory) : StaticFileHandler(std::move(directory), Config()) {
+}
+
+StaticFileHandler::StaticFileHandler(std::string directory, Config config)
+    : m_directory(std::move(directory)), m_config(std::move(config)) {
+    while (m_directory.size() > 1 && m_directory.back() == '/')
+        m_directory.pop_back();
+}
+
+std::shared_ptr<HttpResponse> StaticFileHandler::renderGET(const HttpRequest& req) {
+    std::string path;
+    if (!resolvePath(req.getArg("path"), m_config.indexFile, path))
+        return createNotFoundResponse();
+
+    int64_t now = steadyNow();
+    if (auto entry = find(path)) {
+        int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(m_config.checkInterval).count();
+        bool isFresh = now - entry->checkedAt.load(std::memory_order_relaxed) < interval;
+        FileInfo info;
+        if (!isFresh && statFile(entry->filePath, info) && info.modified == entry->info.modified &&
+            info.size == entry->info.size && info.inode == entry->info.inode) {
+            entry->checkedAt.store(now, std::memory_order_relaxed);
+            isFresh = true;
+        }
+        if (isFresh) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return respond(*entry, req);
+        }
+        debug::log("StaticFileHandler: ", entry->filePath, " changed");
+        erase(path);
+    }
+
+    std::string filePath = m_directory + '/' + path;
+    FileInfo info;
+    if (!statFile(filePath, info))
+        return createNotFoundResponse();
+    if (info.isDirectory) {
+        filePath += '/';
+        filePath += m_config.indexFile;
+        if (!statFile(filePath, info) || info.isDirectory)
+            return createNotFoundResponse();
+    }
+    return load(path, filePath, info, req);
+}
+
+StaticFileHandler::Stats StaticFileHandler::getStats() const {
+    Stats stats;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.loads = m_loads.load(std::memory_order_relaxed);
+    stats.notModified = m_notModified.load(std::memory_order_relaxed);
+    std::shared_lock lock(m_mutex);
+    stats.cachedFiles = m_entries.size();
+    stats.cachedBytes = m_cachedBytes;
+    return stats;
+}
+
+std::string_view StaticFileHandler::getMimeType(std::string_view path) {
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    if (dot != std::string_view::npos && (slash == std::string_view::npos || dot > slash)) {
+        std::string_view extension = path.substr(dot + 1);
+        for (const auto& [name, type] : kMimeTypes) {
+            if (util::equalsIgnoreCase(name, extension))
+                return type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+bool StaticFileHandler::resolvePath(std::string_view encodedPath, const std::string& indexFile, std::string& path) {
+    path.clear();
+    std::string decoded;
+    decoded.reserve(encodedPath.size());
+    for (size_t i = 0; i < encodedPath.size(); ++i) {
+        char c = encodedPath[i];
+        if (c == '%' && i + 2 < encodedPath.size() && hexValue(encodedPath[i + 1]) >= 0 &&
+            hexValue(encodedPath[i + 2]) >= 0) {
+            c = static_cast<char>(hexValue(encodedPath[i + 1]) * 16 + hexValue(encodedPath[i + 2]));
+            i += 2;
+        }
+        // Separators are checked after decoding, "%2e%2e" is ".." as well
+        if (c == '\0' || c == '\\')
+            return false;
+        decoded += c;
+    }
+    std::string_view rest = decoded;
+    while (!rest.empty()) {
+        size_t slash = rest.find('/');
+        std::string_view segment = rest.substr(0, slash);
+        rest.remove_prefix(slash == std::string_view::npos ? rest.size() : slash + 1);
+        if (segment == "." || segment == "..")
+            return false;
+        if (segment.empty())
+            continue;
+        if (!path.empty())
+            path += '/';
+        path += segment;
+    }
+    if (path.empty() || decoded.back() == '/') {
+        if (!path.empty())
+            path += '/';
+        path += indexFile;
+    }
+    return true;
+}
+
+bool StaticFileHandler::statFile(const std::string& filePath, FileInfo& info) {
+    struct stat status;
+    if (stat(filePath.c_str(), &status) != 0)
+        return false;
+    info.isDirectory = (status.st_mode & S_IFMT) == S_IFDIR;
+    if (!info.isDirectory && (status.st_mode & S_IFMT) != S_IFREG)
+        return false;
+    info.modified = status.st_mtime;
+    info.size = static_cast<uint64_t>(status.st_size);
+    info.inode = static_cast<uint64_t>(status.st_ino);
+    return true;
+}
+
+std::shared_ptr<const StaticFileHandler::Entry> StaticFileHandler::find(const std::string& path) const {
+    std::shared_lock lock(m_mutex);
+    auto it = m_entries.find(path);
+    return it == m_entries.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<HttpResponse> StaticFileHandler::load(const std::string& path, const std::string& filePath,
+                                                      const FileInfo& info, const HttpRequest& req) {
+    m_loads.fetch_add(1, std::memory_order_relaxed);
+    bool isCached = info.size <= m_config.maxCachedFileSize;
+    // Larger files stay on disk and are streamed by the connection
+    std::string_view body;
+    std::shared_ptr<const void> owner;
+    std::shared_ptr<const FileBody> file;
+    if (isCached)
+        owner = readFile(filePath, info.size, body);
+    else
+        file = FileBody::open(filePath);
+    if (!owner && !file)
+        return createNotFoundResponse();
+
+    std::string etag = "\"";
+    appendHex(etag, static_cast<uint64_t>(info.modified));
+    etag += '-';
+    appendHex(etag, info.size);
+    etag += '"';
+    std::string lastModified = HttpDate::format(info.modified);
+    HttpResponse response(HttpStatusCode::OK);
+    response.setContentType(std::string(getMimeType(filePath)));
+    response.setHeader("ETag", etag);
+    response.setHeader("Last-Modified", lastModified);
+    response.setHeader("Accept-Ranges", "bytes");
+    if (file)
+        response.setFileBody(std::move(file));
+    else
+        response.setSharedBody(body, std::move(owner));
+    HttpResponse notModified(HttpStatusCode::NOT_MODIFIED);
+    notModified.setContentType(response.getHeader("Content-Type"));
+    notModified.setHeader("ETag", etag);
+
+    auto entry = std::make_shared<Entry>(response, notModified);
+    entry->etag = std::move(etag);
+    entry->lastModified = std::move(lastModified);
+    entry->filePath = filePath;
+    entry->info = info;
+    entry->checkedAt.store(steadyNow(), std::memory_order_relaxed);
+    if (isCached) {
+        std::unique_lock lock(m_mutex);
+        auto& slot = m_entries[path];
+        if (slot)
+            m_cachedBytes -= slot->info.size;
+        if (m_cachedBytes + info.size <= m_config.maxCacheSize) {
+            slot = entry;
+            m_cachedBytes += info.size;
+        } else {
+            m_entries.erase(path);
+        }
+    }
+    return respond(*entry, req);
+}
+
+std::shared_ptr<HttpResponse> StaticFileHandler::respond(const Entry& entry, const HttpRequest& req) {
+    std::string_view ifNoneMatch = req.getHeader("If-None-Match");
+    // If-Modified-Since is compared exactly, clients send back the Last-Modified they got
+    bool isNotModified = ifNoneMatch.empty() ? req.getHeader("If-Modified-Since") == entry.lastModified
+                                             : ResponseCache::matchesIfNoneMatch(ifNoneMatch, entry.etag);
+    if (isNotModified) {
+        m_notModified.fetch_add(1, std::memory_order_relaxed);
+        return entry.notModified.get();
+    }
+    return entry.response.get();
+}
+
+void StaticFileHandler::erase(const std::string& path) {
+    std::unique_lock lock(m_mutex);
+    auto it = m_entries.find(path);
+    if (it == m_entries.end())
+        return;
+    m_cachedBytes -= it->second->info.size;
+    m_entries.erase(it);
+}
+}  // namespace ioteye
@@ -0,0 +1,451 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ioteyeserver/httpserver/tcp_connection.hpp"
+
+#include "ioteyeserver/httpserver/webserver.hpp"
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <iterator>
+
+namespace ioteye {
+
+TcpConnection::TcpConnection(Webserver& server, std::shared_ptr<asio::ip::tcp::socket> socket)
+    : m_server(server),
+      m_socket(std::move(socket)),
+      m_idleTimer(m_socket->get_executor()),
+      m_parser(server.m_maxHeaderSize, server.m_maxBodySize) {
+    m_parser.setHeadCallback([this](HttpRequest& request) { startBody(request); });
+}
+
+void TcpConnection::start() {
+    debug::log("[TCP] Client handling!");
+    // Data is read only after readiness is reported, so a spurious wakeup must not block
+    asio::error_code ec;
+    m_socket->non_blocking(true, ec);
+    // Enter the connection strand before touching the socket
+    asio::dispatch(m_socket->get_executor(), [self = shared_from_this()]() { self->readRequest(); });
+}
+
+void TcpConnection::close() {
+    m_idleTimer.cancel();
+    // A paused consumer gets no more data, and the connection stops keeping itself alive
+    abortBody();
+    m_isChunkParked = false;
+    m_pausedSelf.reset();
+    m_parkedSelf.reset();
+    if (!m_socket->is_open())
+        return;
+    asio::error_code ec;
+    m_socket->shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    m_socket->close(ec);
+}
+
+void TcpConnection::armIdleTimer() {
+    if (m_server.m_idleTimeout.count() <= 0)
+        return;
+    m_idleTimer.expires_after(m_server.m_idleTimeout);
+    m_idleTimer.async_wait([self = shared_from_this()](const asio::error_code& error) {
+        // A long write is not idling, the timer is armed again once it completes. A write
+        // waiting for the notifier of its body generator is
+        if (error != asio::error::operation_aborted && (!self->m_isWriting || self->m_isChunkParked)) {
+            debug::log("[TCP] Idle timeout expired, closing connection");
+            self->close();
+        }
+    });
+}
+
+void TcpConnection::readRequest() {
+    m_isReading = true;
+    armIdleTimer();
+    // Wait for data without a buffer, so idle keep-alive connections don't hold one
+    m_socket->async_wait(asio::ip::tcp::socket::wait_read,
+                         [self = shared_from_this()](const asio::error_code& error) { self->handleReadable(error); });
+}
+
+void TcpConnection::handleReadable(const asio::error_code& error) {
+    if (error) {
+        handleRead(error, 0);
+        return;
+    }
+    if (!m_buffer)
+        m_buffer = m_server.m_bufferPool->acquire();
+    asio::error_code readError;
+    size_t length = m_socket->read_some(asio::buffer(m_buffer.data(), m_buffer.size()), readError);
+    if (readError == asio::error::would_block || readError == asio::error::try_again) {
+        m_buffer.release();
+        m_socket->async_wait(asio::ip::tcp::socket::wait_read,
+                             [self = shared_from_this()](const asio::error_code& error) { self->handleReadable(error); });
+        return;
+    }
+    handleRead(readError, length);
+}
+
+void TcpConnection::handleRead(const asio::error_code& error, std::size_t length) {
+    m_isReading = false;
+    m_idleTimer.cancel();
+    if (error) {
+        m_buffer.release();
+        abortBody();
+        if (error != asio::error::eof && error != asio::error::operation_aborted) {
+            std::lock_guard<std::mutex> lock(m_server.m_coutMutex);
+            std::cerr << "[TCP] Error receiving request: " << error.message() << std::endl;
+        }
+        // Client may half-close after pipelining its requests, answer them first
+        m_keepAlive = false;
+        if (error != asio::error::eof || (!m_isWriting && m_pendingWrites.empty()))
+            close();
+        return;
+    }
+    debug::log("[TCP] request data: ", std::string_view(m_buffer.data(), length));
+    m_bufferBegin = 0;
+    m_bufferEnd = length;
+    processBuffer();
+}
+
+void TcpConnection::processBuffer() {
+    // Answer every complete request already received, responses are queued in request order.
+    // A request is answered only once its body consumer isn't paused any more
+    while (m_keepAlive && !m_isBodyPaused && m_pendingWrites.size() < kMaxPipelinedResponses) {
+        if (!m_parser.isComplete()) {
+            if (m_bufferBegin == m_bufferEnd)
+                break;
+            m_bufferBegin += m_parser.parse(m_buffer.data() + m_bufferBegin, m_bufferEnd - m_bufferBegin);
+            if (m_parser.hasError()) {
+                abortBody();
+                m_keepAlive = false;
+                queueResponse(createErrorResponse(m_parser.getErrorStatus()));
+                break;
+            }
+            if (!m_keepAlive || m_isBodyPaused || !m_parser.isComplete())
+                continue;
+        }
+        handleRequest(m_parser.takeRequest());
+    }
+    if (m_bufferBegin == m_bufferEnd)
+        m_buffer.release();
+    flushResponses();
+    if (!m_keepAlive) {
+        if (!m_isWriting)
+            close();
+        return;
+    }
+    // Read further only when everything received is parsed, otherwise wait for the queue to drain
+    if (!m_isReading && !m_isBodyPaused && m_bufferBegin == m_bufferEnd)
+        readRequest();
+    else if (m_isChunkParked)
+        armIdleTimer();
+}
+
+void TcpConnection::handleRequest(HttpRequest request) {
+    m_keepAlive = m_server.isKeepAlive(request);
+    // A request with a body is routed once its head is parsed already
+    auto resource = m_isRouted ? std::move(m_resource) : m_server.findResource(request);
+    m_isRouted = false;
+    std::shared_ptr<HttpResponse> response;
+    if (m_bodyConsumer) {
+        response = m_server.finishBody(request, *resource, *m_bodyConsumer);
+        m_bodyConsumer.reset();
+    } else {
+        response = m_server.routeRequest(request, resource);
+    }
+    ++m_requestsServed;
+    size_t maxRequests = m_server.m_maxRequestsPerConnection;
+    // Added when the head is written, the response itself may be shared with other requests
+    std::string_view connection;
+    if (m_keepAlive && maxRequests > 0 && m_requestsServed >= maxRequests) {
+        // The client expects the connection to stay open, so tell it explicitly
+        m_keepAlive = false;
+        connection = "close";
+    } else if (m_keepAlive && request.getVersion() == "HTTP/1.0") {
+        connection = "keep-alive";
+    }
+    // HTTP/1.0 has no chunked encoding, the body is sent with its length
+    if (response->getBodyGenerator() && request.getVersion() == "HTTP/1.0")
+        response = loadBody(std::move(response));
+    queueResponse(std::move(response), connection);
+}
+
+void TcpConnection::startBody(HttpRequest& request) {
+    m_resource = m_server.findResource(request);
+    m_isRouted = true;
+    m_bodyConsumer = m_server.createBodyConsumer(request, m_resource);
+    if (!m_bodyConsumer)
+        return;
+    m_bodyConsumer->m_resume = [weak = weak_from_this()]() {
+        if (auto self = weak.lock())
+            asio::post(self->m_socket->get_executor(), [self]() { self->resumeBody(); });
+    };
+    m_parser.setBodyConsumer([this](std::string_view data) { return consumeBody(data); });
+}
+
+bool TcpConnection::consumeBody(std::string_view data) {
+    try {
+        if (m_bodyConsumer->onData(data))
+            return true;
+        m_isBodyPaused = true;
+        m_pausedSelf = shared_from_this();
+        // A consumer which never resumes must not hold the connection forever
+        armIdleTimer();
+    } catch (const std::exception& e) {
+        {
+            std::lock_guard<std::mutex> lock(m_server.m_coutMutex);
+            std::cerr << "[TCP] Exception in body consumer: " << e.what() << std::endl;
+        }
+        // Rest of the body is never read, so the connection can't be reused
+        m_bodyConsumer.reset();
+        m_resource.reset();
+        m_isRouted = false;
+        m_keepAlive = false;
+        queueResponse(createErrorResponse(HttpStatusCode::INTERNAL_SERVER_ERROR));
+    }
+    return false;
+}
+
+void TcpConnection::resumeBody() {
+    if (!m_isBodyPaused)
+        return;
+    m_isBodyPaused = false;
+    m_idleTimer.cancel();
+    auto self = std::move(m_pausedSelf);
+    processBuffer();
+}
+
+void TcpConnection::abortBody() {
+    m_resource.reset();
+    m_isRouted = false;
+    if (!m_bodyConsumer)
+        return;
+    auto consumer = std::move(m_bodyConsumer);
+    m_isBodyPaused = false;
+    m_pausedSelf.reset();
+    consumer->onAbort();
+}
+
+void TcpConnection::queueResponse(std::shared_ptr<HttpResponse> response, std::string_view connection) {
+    m_pendingWrites.push_back({std::move(response), connection, std::string()});
+}
+
+void TcpConnection::flushResponses() {
+    if (m_isWriting || m_pendingWrites.empty())
+        return;
+    // Queued responses go out in one gathered write, up to the first one with a file or a
+    // generated body
+    m_isWriting = true;
+    auto fileIt = std::find_if(m_pendingWrites.begin(), m_pendingWrites.end(), [](const Write& write) {
+        const auto& response = write.response;
+        return (response->getFileBody() || response->getBodyGenerator()) && !response->isHeadOnly();
+    });
+    if (fileIt == m_pendingWrites.end()) {
+        m_activeWrites.swap(m_pendingWrites);
+    } else {
+        m_activeWrites.assign(std::make_move_iterator(m_pendingWrites.begin()), std::make_move_iterator(fileIt + 1));
+        m_pendingWrites.erase(m_pendingWrites.begin(), fileIt + 1);
+    }
+    std::vector<asio::const_buffer> buffers;
+    buffers.reserve(m_activeWrites.size() * 2);
+    for (auto& write : m_activeWrites) {
+        auto responseBuffers = write.response->toBuffers(write.head, write.connection);
+        buffers.insert(buffers.end(), responseBuffers.begin(), responseBuffers.end());
+    }
+    asio::async_write(*m_socket, buffers,
+                      [self = shared_from_this()](const asio::error_code& error, std::size_t bytesTransfered) {
+                          self->handleWrite(error, bytesTransfered);
+                      });
+}
+
+void TcpConnection::handleWrite(const asio::error_code& error, std::size_t bytesTransfered) {
+    if (error) {
+        m_isWriting = false;
+        m_activeWrites.clear();
+        debug::log("[TCP] Error sending response: ", error.message());
+        close();
+        return;
+    }
+    debug::log("[TCP] Response sent successfully. BytesTransfered: ", bytesTransfered);
+    const auto& last = m_activeWrites.back().response;
+    if (last->getFileBody() && !last->isHeadOnly() && last->getBodySize() > 0) {
+        m_fileOffset = last->getFileOffset();
+        m_fileRemaining = last->getBodySize();
+        sendFile();
+        return;
+    }
+    if (last->getBodyGenerator() && !last->isHeadOnly()) {
+        if (const auto& notifier = last->getBodyNotifier()) {
+            notifier->setResume([weak = weak_from_this()]() {
+                if (auto self = weak.lock())
+                    asio::post(self->m_socket->get_executor(), [self]() { self->resumeChunk(); });
+            });
+        }
+        sendChunk();
+        return;
+    }
+    finishWrite();
+}
+
+void TcpConnection::sendFile() {
+    const FileBody& file = *m_activeWrites.back().response->getFileBody();
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(m_fileRemaining, m_server.m_maxInFlightBytes));
+#ifdef __linux__
+    off_t offset = static_cast<off_t>(m_fileOffset);
+    ssize_t sent = ::sendfile(m_socket->native_handle(), file.getDescriptor(), &offset, chunk);
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        handleWrite(asio::error_code(errno, asio::error::get_system_category()), 0);
+        return;
+    }
+    if (sent == 0) {
+        // File got shorter than its Content-Length, the response can't be completed
+        handleWrite(asio::error::eof, 0);
+        return;
+    }
+    if (sent > 0) {
+        m_fileOffset += static_cast<uint64_t>(sent);
+        m_fileRemaining -= static_cast<uint64_t>(sent);
+    }
+    if (m_fileRemaining == 0) {
+        finishWrite();
+        return;
+    }
+    // Other connections get their turn before the next chunk
+    m_socket->async_wait(asio::ip::tcp::socket::wait_write, [self = shared_from_this()](const asio::error_code& error) {
+        if (error)
+            self->handleWrite(error, 0);
+        else
+            self->sendFile();
+    });
+#else
+    m_chunk.resize(chunk);
+    long long count = file.read(m_fileOffset, m_chunk.data(), chunk);
+    if (count <= 0) {
+        handleWrite(asio::error::eof, 0);
+        return;
+    }
+    m_fileOffset += static_cast<uint64_t>(count);
+    m_fileRemaining -= static_cast<uint64_t>(count);
+    asio::async_write(*m_socket, asio::buffer(m_chunk.data(), static_cast<size_t>(count)),
+                      [self = shared_from_this()](const asio::error_code& error, std::size_t) {
+                          if (error)
+                              self->handleWrite(error, 0);
+                          else if (self->m_fileRemaining == 0)
+                              self->finishWrite();
+                          else
+                              self->sendFile();
+                      });
+#endif
+}
+
+void TcpConnection::sendChunk() {
+    static constexpr std::string_view kChunkEnd = "\r\n";
+    static constexpr std::string_view kLastChunk = "0\r\n\r\n";
+    m_chunk.clear();
+    bool isLast;
+    try {
+        isLast = !m_activeWrites.back().response->getBodyGenerator()(m_chunk);
+    } catch (const std::exception& e) {
+        // The head is sent already, closing without the last chunk tells the client the body is incomplete
+        std::lock_guard<std::mutex> lock(m_server.m_coutMutex);
+        std::cerr << "[TCP] Exception in body generator: " << e.what() << std::endl;
+        handleWrite(asio::error::operation_aborted, 0);
+        return;
+    }
+    if (m_chunk.empty() && !isLast) {
+        if (!m_activeWrites.back().response->getBodyNotifier()) {
+            {
+                std::lock_guard<std::mutex> lock(m_server.m_coutMutex);
+                std::cerr << "[TCP] Body generator has no data ready and no notifier" << std::endl;
+            }
+            handleWrite(asio::error::operation_aborted, 0);
+            return;
+        }
+        // Nothing is pending until the notifier resumes the generator
+        m_isChunkParked = true;
+        m_parkedSelf = shared_from_this();
+        armIdleTimer();
+        return;
+    }
+    std::array<asio::const_buffer, 4> buffers;
+    if (!m_chunk.empty()) {
+        char digits[16];
+        auto result = std::to_chars(digits, digits + sizeof(digits), m_chunk.size(), 16);
+        m_chunkSize.assign(digits, result.ptr);
+        m_chunkSize += kChunkEnd;
+        buffers[0] = asio::buffer(m_chunkSize);
+        buffers[1] = asio::buffer(m_chunk);
+        buffers[2] = asio::buffer(kChunkEnd.data(), kChunkEnd.size());
+    }
+    if (isLast)
+        buffers[3] = asio::buffer(kLastChunk.data(), kLastChunk.size());
+    // The generator is asked for the next chunk only once this one is written
+    asio::async_write(*m_socket, buffers,
+                      [self = shared_from_this(), isLast](const asio::error_code& error, std::size_t) {
+                          if (error)
+                              self->handleWrite(error, 0);
+                          else if (isLast)
+                              self->finishWrite();
+                          else
+                              self->sendChunk();
+                      });
+}
+
+void TcpConnection::resumeChunk() {
+    if (!m_isChunkParked)
+        return;
+    m_isChunkParked = false;
+    if (!m_isReading)
+        m_idleTimer.cancel();
+    auto self = std::move(m_parkedSelf);
+    sendChunk();
+}
+
+void TcpConnection::finishWrite() {
+    m_isWriting = false;
+    m_activeWrites.clear();
+    m_chunk = std::string();
+    if (!m_pendingWrites.empty()) {
+        flushResponses();
+        return;
+    }
+    if (!m_keepAlive) {
+        close();
+        return;
+    }
+    if (m_isBodyPaused)
+        armIdleTimer();
+    else if (m_bufferBegin < m_bufferEnd)
+        processBuffer();
+    else if (m_isReading)
+        armIdleTimer();
+    else
+        readRequest();
+}
+
+}  // namespace ioteye
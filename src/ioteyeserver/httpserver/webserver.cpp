@@ -24,31 +24,120 @@ SOFTWARE.
 
 #include "ioteyeserver/httpserver/webserver.hpp"
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
 namespace ioteye {
 
-Webserver::Webserver(int tcpPort, int udpPort, bool udpOn, ResourceMap resourceMap, size_t bufferSize)
-    : m_tcpPort(tcpPort),
-      m_udpPort(udpPort),
-      m_resourceMap(std::move(resourceMap)),
-      m_tcpAcceptor(m_ioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), tcpPort)),
-      m_isUdpOn(udpOn),
-      m_methodHandlers{
-          {HttpMethod::HTTP_GET, [](std::shared_ptr<HttpResourceHandler> handler,
-                               const HttpRequest& request) { return handler->renderGET(request); }},
-          {HttpMethod::HTTP_POST, [](std::shared_ptr<HttpResourceHandler> handler,
-                                const HttpRequest& request) { return handler->renderPOST(request); }},
-          {HttpMethod::HTTP_PUT, [](std::shared_ptr<HttpResourceHandler> handler,
-                               const HttpRequest& request) { return handler->renderPUT(request); }},
-          {HttpMethod::HTTP_DELETE, [](std::shared_ptr<HttpResourceHandler> handler,
-                                  const HttpRequest& request) { return handler->renderDELETE(request); }}},
-      m_bufferSize(bufferSize) {
-    if (m_isUdpOn)
-        m_udpSocket = std::make_shared<asio::ip::udp::socket>(
-            m_ioContext, asio::ip::udp::endpoint(asio::ip::udp::v4(), m_udpPort));
+namespace {
+std::array<MethodHandler, HttpMethod::HTTP_METHOD_MAX> createMethodHandlers() {
+    std::array<MethodHandler, HttpMethod::HTTP_METHOD_MAX> handlers;
+    handlers[HttpMethod::HTTP_GET] = [](std::shared_ptr<HttpResourceHandler> handler, const HttpRequest& request) {
+        return handler->renderGET(request);
+    };
+    handlers[HttpMethod::HTTP_POST] = [](std::shared_ptr<HttpResourceHandler> handler, const HttpRequest& request) {
+        return handler->renderPOST(request);
+    };
+    handlers[HttpMethod::HTTP_PUT] = [](std::shared_ptr<HttpResourceHandler> handler, const HttpRequest& request) {
+        return handler->renderPUT(request);
+    };
+    handlers[HttpMethod::HTTP_DELETE] = [](std::shared_ptr<HttpResourceHandler> handler, const HttpRequest& request) {
+        return handler->renderDELETE(request);
+    };
+    // HEAD is rendered as GET, its body is dropped when the response is written
+    handlers[HttpMethod::HTTP_HEAD] = [](std::shared_ptr<HttpResourceHandler> handler, const HttpRequest& request) {
+        auto response = makeMutable(handler->renderGET(request));
+        if (response)
+            response->setHeadOnly(true);
+        return response;
+    };
+    handlers[HttpMethod::HTTP_PATCH] = [](std::shared_ptr<HttpResourceHandler> handler, const HttpRequest& request) {
+        return handler->renderPATCH(request);
+    };
+    return handlers;
+}
+}  // namespace
+
+// Only touched from the UDP socket strand, except for the statistics
+struct Webserver::UdpBatch {
+    UdpBatch(size_t batchSize, size_t bufferSize)
+        : bufferSize(bufferSize),
+          storage(batchSize * bufferSize),
+          senders(batchSize),
+          fillHistogram(new std::atomic<size_t>[batchSize + 1]) {
+        for (size_t i = 0; i <= batchSize; ++i)
+            fillHistogram[i] = 0;
+        responses.reserve(batchSize);
+#ifdef __linux__
+        receiveIovecs.resize(batchSize);
+        receiveHeaders.resize(batchSize);
+        sendIovecs.resize(batchSize * 2);
+        sendHeaders.resize(batchSize);
+        sendHeads.resize(batchSize);
+#endif
+    }
+
+    size_t bufferSize;
+    std::vector<char> storage;
+    std::vector<asio::ip::udp::endpoint> senders;
+    // Responses of the current batch with index of the datagram they answer
+    std::vector<std::pair<std::shared_ptr<HttpResponse>, size_t>> responses;
+#ifdef __linux__
+    std::vector<iovec> receiveIovecs;
+    std::vector<mmsghdr> receiveHeaders;
+    std::vector<iovec> sendIovecs;
+    std::vector<mmsghdr> sendHeaders;
+    // Serialized heads of the responses, referenced by sendIovecs
+    std::vector<std::string> sendHeads;
+#endif
+    std::atomic<size_t> batches{0};
+    std::atomic<size_t> datagrams{0};
+    std::unique_ptr<std::atomic<size_t>[]> fillHistogram;
+};
+
+Webserver::Webserver(Builder& builder)
+    : m_tcpPort(builder.m_tcpPort),
+      m_udpPort(builder.m_udpPort),
+      m_resourceMap(std::move(builder.m_resourceMap)),
+      m_tcpAcceptor(m_ioContext),
+      m_dateTimer(m_ioContext),
+      m_isUdpOn(builder.m_isUdpOn),
+      m_udpBatchSize(builder.m_udpBatchSize),
+      m_udpReceiveDepth(builder.m_udpReceiveDepth),
+      m_udpSocketCount(builder.m_udpSocketCount),
+      m_methodHandlers(createMethodHandlers()),
+      m_threadCount(builder.m_threadCount),
+      m_bufferSize(builder.m_bufferSize),
+      m_maxRequestsPerConnection(builder.m_maxRequestsPerConnection),
+      m_idleTimeout(builder.m_idleTimeout),
+      m_maxHeaderSize(builder.m_maxHeaderSize),
+      m_maxBodySize(builder.m_maxBodySize),
+      m_maxInFlightBytes(builder.m_maxInFlightBytes),
+      m_shardCount(builder.m_shardCount),
+      m_bufferPoolSize(builder.m_bufferPoolSize),
+      m_bufferPool(std::make_shared<BufferPool>(m_bufferSize, m_bufferPoolSize)),
+      m_compression(builder.m_compression),
+      m_compressor(std::make_shared<ResponseCompressor>()) {
+    for (const auto& [pattern, resource] : m_resourceMap)
+        m_router.addResource(resource);
+    m_router.build();
+    openTcpListeners();
+    openUdpSockets();
     debug::log("Webserver constructed");
 }
 
-Webserver::Webserver() : m_tcpAcceptor(m_ioContext) {
+Webserver::Webserver()
+    : m_tcpAcceptor(m_ioContext),
+      m_dateTimer(m_ioContext),
+      m_bufferPool(std::make_shared<BufferPool>(m_bufferSize, m_bufferPoolSize)),
+      m_compressor(std::make_shared<ResponseCompressor>()) {
     debug::log("Webserver default constructed");
 }
 
@@ -61,21 +150,34 @@ Webserver::Webserver(Webserver&& other) noexcept
     : m_tcpPort(other.m_tcpPort),
       m_udpPort(other.m_udpPort),
       m_resourceMap(std::move(other.m_resourceMap)),
+      m_router(std::move(other.m_router)),
       m_ioContext(),
-      m_tcpAcceptor(m_ioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), 0)),
+      m_tcpAcceptor(m_ioContext),
+      m_dateTimer(m_ioContext),
       m_isUdpOn(other.m_isUdpOn),
-      m_remoteEndpoint(),
+      m_udpBatchSize(other.m_udpBatchSize),
+      m_udpReceiveDepth(other.m_udpReceiveDepth),
+      m_udpSocketCount(other.m_udpSocketCount),
       m_keepRunning(false),
       m_coutMutex(),
       m_methodHandlers(std::move(other.m_methodHandlers)),
-      m_ioContextThread(),
-      m_bufferSize(other.m_bufferSize) {
+      m_ioContextThreads(),
+      m_threadCount(other.m_threadCount),
+      m_bufferSize(other.m_bufferSize),
+      m_maxRequestsPerConnection(other.m_maxRequestsPerConnection),
+      m_idleTimeout(other.m_idleTimeout),
+      m_maxHeaderSize(other.m_maxHeaderSize),
+      m_maxBodySize(other.m_maxBodySize),
+      m_maxInFlightBytes(other.m_maxInFlightBytes),
+      m_shardCount(other.m_shardCount),
+      m_bufferPoolSize(other.m_bufferPoolSize),
+      m_bufferPool(std::move(other.m_bufferPool)),
+      m_compression(other.m_compression),
+      m_compressor(std::move(other.m_compressor)) {
     other.shutdown();
     debug::log("Webserver moved");
-    m_tcpAcceptor =
-        asio::ip::tcp::acceptor(m_ioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), m_tcpPort));
-    m_udpSocket = std::make_shared<asio::ip::udp::socket>(
-        m_ioContext, asio::ip::udp::endpoint(asio::ip::udp::v4(), m_udpPort));
+    openTcpListeners();
+    openUdpSockets();
 }
 
 Webserver& Webserver::operator=(Webserver&& other) noexcept {
@@ -88,12 +190,25 @@ Webserver& Webserver::operator=(Webserver&& other) noexcept {
     m_tcpPort = other.m_tcpPort;
     m_udpPort = other.m_udpPort;
     m_isUdpOn = other.m_isUdpOn;
+    m_udpBatchSize = other.m_udpBatchSize;
+    m_udpReceiveDepth = other.m_udpReceiveDepth;
+    m_udpSocketCount = other.m_udpSocketCount;
+    m_threadCount = other.m_threadCount;
     m_bufferSize = other.m_bufferSize;
-    m_tcpAcceptor =
-        asio::ip::tcp::acceptor(m_ioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), m_tcpPort));
-    m_udpSocket = std::make_shared<asio::ip::udp::socket>(
-        m_ioContext, asio::ip::udp::endpoint(asio::ip::udp::v4(), m_udpPort));
+    m_maxRequestsPerConnection = other.m_maxRequestsPerConnection;
+    m_idleTimeout = other.m_idleTimeout;
+    m_maxHeaderSize = other.m_maxHeaderSize;
+    m_maxBodySize = other.m_maxBodySize;
+    m_maxInFlightBytes = other.m_maxInFlightBytes;
+    m_shardCount = other.m_shardCount;
+    m_bufferPoolSize = other.m_bufferPoolSize;
+    m_bufferPool = std::move(other.m_bufferPool);
+    m_compression = other.m_compression;
+    m_compressor = std::move(other.m_compressor);
+    openTcpListeners();
+    openUdpSockets();
     m_resourceMap = std::move(other.m_resourceMap);
+    m_router = std::move(other.m_router);
     m_methodHandlers = std::move(other.m_methodHandlers);
     m_keepRunning = false;
     return *this;
@@ -105,19 +220,36 @@ void Webserver::start() {
     else
         m_keepRunning = true;
     try {
-        {
-            std::lock_guard<std::mutex> lock(m_coutMutex);
-            debug::log("[TCP] Server is listening on port ", m_tcpPort);
-        }
+        debug::log("[TCP] Server is listening on port ", m_tcpPort);
         if (m_isUdpOn) {
-            {
-                std::lock_guard<std::mutex> lock(m_coutMutex);
-                debug::log("[UDP] Server is listening on port ", m_udpPort);
+            debug::log("[UDP] Server is listening on port ", m_udpPort, " with ", m_udpSockets.size(),
+                       " sockets");
+            for (size_t i = 0; i < m_udpSockets.size(); ++i) {
+                if (!m_udpBatches.empty()) {
+                    receiveUdpBatch(m_udpSockets[i], *m_udpBatches[i]);
+                    continue;
+                }
+                for (size_t j = 0; j < std::max<size_t>(m_udpReceiveDepth, 1); ++j)
+                    receiveUdpRequest(m_udpSockets[i]);
+            }
+        }
+        if (m_shards.empty()) {
+            acceptTcpConnection(m_tcpAcceptor);
+        } else {
+            unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+            for (size_t i = 0; i < m_shards.size(); ++i) {
+                Shard& shard = *m_shards[i];
+                acceptTcpConnection(shard.acceptor);
+                shard.thread = std::thread([&shard]() { shard.ioContext.run(); });
+                pinThreadToCore(shard.thread, i % cores);
             }
-            receiveUdpRequest();
+            debug::log("[TCP] Running ", m_shards.size(), " shards");
         }
-        acceptTcpConnection();
-        m_ioContextThread = std::thread([this]() { m_ioContext.run(); });
+        tickDate();
+        size_t threadCount = std::max<size_t>(m_threadCount, 1);
+        debug::log("Running io_context on ", threadCount, " threads");
+        for (size_t i = 0; i < threadCount; ++i)
+            m_ioContextThreads.emplace_back([this]() { m_ioContext.run(); });
     } catch (std::exception& e) {
         std::cerr << "Exception: " << e.what() << std::endl;
     }
@@ -126,6 +258,8 @@ void Webserver::start() {
 void Webserver::shutdown() {
     debug::log("Shutdown called");
     m_keepRunning = false;
+    m_dateTimer.cancel();
+    HttpDate::stopTicking();
     if (!m_ioContext.stopped()) {
         debug::log("Stopping io_context");
         m_ioContext.stop();
@@ -134,29 +268,132 @@ void Webserver::shutdown() {
         debug::log("Closing tcpAcceptor");
         m_tcpAcceptor.close();
     }
-    if (m_udpSocket && m_udpSocket->is_open()) {
+    for (auto& shard : m_shards) {
+        shard->ioContext.stop();
+        asio::error_code ec;
+        shard->acceptor.close(ec);
+    }
+    for (auto& udpSocket : m_udpSockets) {
+        if (!udpSocket->is_open())
+            continue;
         debug::log("Closing udpSocket");
         asio::error_code ec;
-        m_udpSocket->close(ec);
+        udpSocket->close(ec);
         if (ec) {
             std::cerr << "Error closing UDP socket: " << ec.message() << std::endl;
         }
     }
-    if (m_ioContextThread.joinable()) {
-        debug::log("Joining io_contextThread");
-        m_ioContextThread.join();
+    debug::log("Joining io_context threads");
+    for (auto& thread : m_ioContextThreads) {
+        if (thread.joinable())
+            thread.join();
+    }
+    m_ioContextThreads.clear();
+    for (auto& shard : m_shards) {
+        if (shard->thread.joinable())
+            shard->thread.join();
     }
     debug::log("Shutdown complete");
 }
 
-void Webserver::acceptTcpConnection() {
-    auto socketPtr = std::make_shared<asio::ip::tcp::socket>(m_ioContext);
-    m_tcpAcceptor.async_accept(*socketPtr, [this, socketPtr](const asio::error_code& error) {
+void Webserver::tickDate() {
+    HttpDate::tick();
+    // Wake up right after the next second begins
+    auto sinceSecond = std::chrono::system_clock::now().time_since_epoch() % std::chrono::seconds(1);
+    m_dateTimer.expires_after(std::chrono::seconds(1) - sinceSecond);
+    m_dateTimer.async_wait([this](const asio::error_code& error) {
+        if (!error && m_keepRunning)
+            tickDate();
+    });
+}
+
+BufferPool::Stats Webserver::getBufferPoolStats() const {
+    return m_bufferPool ? m_bufferPool->getStats() : BufferPool::Stats();
+}
+
+void Webserver::openTcpListeners() {
+    asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), m_tcpPort);
+    m_shards.clear();
+    if (m_shardCount == 0) {
+        m_tcpAcceptor = asio::ip::tcp::acceptor(m_ioContext, endpoint);
+        return;
+    }
+#ifdef SO_REUSEPORT
+    // Every shard listens on the same port, the kernel balances accepted connections
+    using ReusePort = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    for (size_t i = 0; i < m_shardCount; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->acceptor.open(endpoint.protocol());
+        shard->acceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+        shard->acceptor.set_option(ReusePort(true));
+        shard->acceptor.bind(endpoint);
+        shard->acceptor.listen();
+        m_shards.push_back(std::move(shard));
+    }
+#else
+    throw std::runtime_error("Sharded mode requires SO_REUSEPORT support");
+#endif
+}
+
+void Webserver::openUdpSockets() {
+    m_udpSockets.clear();
+    m_udpBatches.clear();
+    if (!m_isUdpOn)
+        return;
+    asio::ip::udp::endpoint endpoint(asio::ip::udp::v4(), m_udpPort);
+    size_t socketCount = m_udpSocketCount ? m_udpSocketCount : std::max<size_t>(m_threadCount, 1);
+    if (socketCount == 1) {
+        m_udpSockets.push_back(std::make_shared<asio::ip::udp::socket>(asio::make_strand(m_ioContext), endpoint));
+    } else {
+#ifdef SO_REUSEPORT
+        // Kernel spreads datagrams over the sockets by sender, each socket has its own strand
+        using ReusePort = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+        for (size_t i = 0; i < socketCount; ++i) {
+            auto socket = std::make_shared<asio::ip::udp::socket>(asio::make_strand(m_ioContext));
+            socket->open(endpoint.protocol());
+            socket->set_option(asio::ip::udp::socket::reuse_address(true));
+            socket->set_option(ReusePort(true));
+            socket->bind(endpoint);
+            m_udpSockets.push_back(std::move(socket));
+        }
+#else
+        throw std::runtime_error("Several UDP sockets require SO_REUSEPORT support");
+#endif
+    }
+#ifdef __linux__
+    if (m_udpBatchSize > 1) {
+        for (size_t i = 0; i < m_udpSockets.size(); ++i)
+            m_udpBatches.push_back(std::make_unique<UdpBatch>(m_udpBatchSize, m_bufferSize));
+    }
+#endif
+}
+
+void Webserver::pinThreadToCore(std::thread& thread, size_t core) {
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+    int result = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+    if (result != 0)
+        debug::log("Failed to pin thread to core ", core, ": ", result);
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+
+void Webserver::acceptTcpConnection(asio::ip::tcp::acceptor& acceptor) {
+    std::shared_ptr<asio::ip::tcp::socket> socketPtr;
+    if (m_shards.empty()) {
+        // Every connection gets its own strand, so its handlers never run concurrently
+        socketPtr = std::make_shared<asio::ip::tcp::socket>(asio::make_strand(m_ioContext));
+    } else {
+        // Shard io_context is run by a single thread, nothing to serialize
+        socketPtr = std::make_shared<asio::ip::tcp::socket>(acceptor.get_executor());
+    }
+    acceptor.async_accept(*socketPtr, [this, &acceptor, socketPtr](const asio::error_code& error) {
         if (!error) {
-            {
-                std::lock_guard<std::mutex> lock(m_coutMutex);
-                debug::log("TCP client connected!");
-            }
+            debug::log("TCP client connected!");
             handleTcpConnection(socketPtr);
         } else {
             {
@@ -165,51 +402,28 @@ void Webserver::acceptTcpConnection() {
             }
         }
         if (m_keepRunning)
-            acceptTcpConnection();
+            acceptTcpConnection(acceptor);
     });
 }
 
 void Webserver::handleTcpConnection(std::shared_ptr<asio::ip::tcp::socket> socketPtr) {
-    {
-        std::lock_guard<std::mutex> lock(m_coutMutex);
-        debug::log("[TCP] Client handling!");
-    }
-    auto buffer = std::make_shared<std::vector<char>>(m_bufferSize);
-    socketPtr->async_read_some(
-        asio::buffer(*buffer), [this, socketPtr, buffer](const asio::error_code& error, std::size_t length) {
-            if (!error) {
-                std::string requestData(buffer->begin(), buffer->begin() + length);
-                {
-                    std::lock_guard<std::mutex> lock(m_coutMutex);
-                    debug::log("[TCP] request data: ", requestData);
-                }
-                handleRequestData(requestData, [socketPtr](const ioteye::HttpResponse& response) {
-                    sendTcpResponse(response, socketPtr);
-                });
-            } else {
-                std::lock_guard<std::mutex> lock(m_coutMutex);
-                std::cerr << "[TCP] Error receiving request: " << error.message() << std::endl;
-            }
-        });
+    std::make_shared<TcpConnection>(*this, std::move(socketPtr))->start();
 }
 
-void Webserver::receiveUdpRequest() {
-    auto buffer = std::make_shared<std::vector<char>>(m_bufferSize);
-    m_udpSocket->async_receive_from(
-        asio::buffer(*buffer), m_remoteEndpoint,
-        [this, buffer](const asio::error_code& error, std::size_t length) mutable {
-            {
-                std::lock_guard<std::mutex> lock(m_coutMutex);
-                debug::log("[UDP] Client handling!");
-            }
+void Webserver::receiveUdpRequest(std::shared_ptr<asio::ip::udp::socket> socket) {
+    BufferPool::Lease buffer = m_bufferPool->acquire();
+    asio::mutable_buffer receiveBuffer(buffer.data(), buffer.size());
+    // Sender is stored per datagram, so a response can't be addressed to another client
+    auto remoteEndpoint = std::make_shared<asio::ip::udp::endpoint>();
+    socket->async_receive_from(
+        receiveBuffer, *remoteEndpoint,
+        [this, socket, buffer = std::move(buffer), remoteEndpoint](const asio::error_code& error,
+                                                                   std::size_t length) {
+            debug::log("[UDP] Client handling!");
             if (!error) {
-                std::string requestData(buffer->begin(), buffer->begin() + length);
-                {
-                    std::lock_guard<std::mutex> lock(m_coutMutex);
-                    debug::log("[UDP] request data: ", requestData);
-                }
-                handleRequestData(requestData, [this](const ioteye::HttpResponse& response) mutable {
-                    sendUdpResponse(response, m_udpSocket, m_remoteEndpoint);
+                debug::log("[UDP] request data: ", std::string_view(buffer.data(), length));
+                handleRequestData(buffer.data(), length, [socket, remoteEndpoint](std::shared_ptr<HttpResponse> response) {
+                    sendUdpResponse(response, socket, *remoteEndpoint);
                 });
             } else {
                 {
@@ -217,85 +431,215 @@ void Webserver::receiveUdpRequest() {
                     std::cerr << "[UDP] Error receiving request: " << error.message() << std::endl;
                 }
             }
-            receiveUdpRequest();
+            if (m_keepRunning)
+                receiveUdpRequest(socket);
         });
 }
 
-void Webserver::handleRequestData(const std::string& requestData,
-                                  std::function<void(const ioteye::HttpResponse&)> sendResponse) {
-    HttpRequest request;
-    size_t firstLineEnd = 0;
-    if ((firstLineEnd = requestData.find("\r\n")) == std::string::npos) {
-        debug::log("Error, first line not found");
-        sendResponse(*createBadRequestResponse());
-        return;
+void Webserver::receiveUdpBatch(std::shared_ptr<asio::ip::udp::socket> socket, UdpBatch& batch) {
+    // Datagrams are pulled by recvmmsg once the socket reports readiness
+    socket->async_wait(asio::ip::udp::socket::wait_read, [this, socket, &batch](const asio::error_code& error) {
+        if (!error) {
+            handleUdpBatch(socket, batch);
+        } else if (error != asio::error::operation_aborted) {
+            std::lock_guard<std::mutex> lock(m_coutMutex);
+            std::cerr << "[UDP] Error waiting for requests: " << error.message() << std::endl;
+        }
+        if (m_keepRunning)
+            receiveUdpBatch(socket, batch);
+    });
+}
+
+void Webserver::handleUdpBatch(std::shared_ptr<asio::ip::udp::socket> socket, UdpBatch& batch) {
+#ifdef __linux__
+    size_t batchSize = batch.senders.size();
+    for (size_t i = 0; i < batchSize; ++i) {
+        batch.receiveIovecs[i].iov_base = batch.storage.data() + i * batch.bufferSize;
+        batch.receiveIovecs[i].iov_len = batch.bufferSize;
+        msghdr& header = batch.receiveHeaders[i].msg_hdr;
+        header = msghdr();
+        header.msg_name = batch.senders[i].data();
+        header.msg_namelen = static_cast<socklen_t>(batch.senders[i].capacity());
+        header.msg_iov = &batch.receiveIovecs[i];
+        header.msg_iovlen = 1;
     }
-    std::string firstLine = requestData.substr(0, firstLineEnd);
-    std::string requestPart = requestData.substr(firstLineEnd + 2);
-    // Get the Method, URI and Protocol from the first line
-    std::vector<std::string> parts = util::splitString(firstLine, ' ');
-    if (parts.size() < 3) {
-        debug::log("Incorrect first line");
-        sendResponse(*createBadRequestResponse());
+    int received = recvmmsg(socket->native_handle(), batch.receiveHeaders.data(),
+                            static_cast<unsigned>(batchSize), MSG_DONTWAIT, nullptr);
+    if (received <= 0) {
+        if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            debug::log("[UDP] recvmmsg failed: ", std::strerror(errno));
         return;
     }
-    request.setMethod(util::stringToHttpMethod(parts[0]));
-    if (parts[1].back() == '/')
-        parts[1].pop_back();
-    request.setUri(parts[1]);
-    // Split Parts into header and body
-    size_t headerEnd = requestPart.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
-        request.setHeaders(requestPart);
-    } else {
-        request.setHeaders(requestPart.substr(0, headerEnd));
-        request.setBody(requestPart.substr(headerEnd + 4));
+    batch.batches.fetch_add(1, std::memory_order_relaxed);
+    batch.datagrams.fetch_add(received, std::memory_order_relaxed);
+    batch.fillHistogram[received].fetch_add(1, std::memory_order_relaxed);
+    debug::log("[UDP] Received batch of ", received, " datagrams");
+
+    for (size_t i = 0; i < static_cast<size_t>(received); ++i) {
+        batch.senders[i].resize(batch.receiveHeaders[i].msg_hdr.msg_namelen);
+        handleRequestData(batch.storage.data() + i * batch.bufferSize, batch.receiveHeaders[i].msg_len,
+                          [&batch, i](std::shared_ptr<HttpResponse> response) {
+                              batch.responses.emplace_back(std::move(response), i);
+                          });
     }
-    // Match to resources
-    for (const auto& [pattern, resource] : m_resourceMap) {
-        debug::log("Pattern: ", pattern, " request: ", request.getUri());
-        if (matchUrl(request, resource)) {
-            std::shared_ptr<HttpResponse> response = handleRequest(request, pattern);
-            sendResponse(*response);
-            return;
+    sendUdpBatch(socket, batch);
+#else
+    (void)socket;
+    (void)batch;
+#endif
+}
+
+void Webserver::sendUdpBatch(std::shared_ptr<asio::ip::udp::socket> socket, UdpBatch& batch) {
+    size_t sent = 0;
+#ifdef __linux__
+    size_t count = batch.responses.size();
+    for (size_t i = 0; i < count; ++i) {
+        auto& [response, senderIndex] = batch.responses[i];
+        auto buffers = response->toBuffers(batch.sendHeads[i]);
+        for (size_t j = 0; j < buffers.size(); ++j) {
+            batch.sendIovecs[i * 2 + j].iov_base = const_cast<void*>(buffers[j].data());
+            batch.sendIovecs[i * 2 + j].iov_len = buffers[j].size();
         }
+        msghdr& header = batch.sendHeaders[i].msg_hdr;
+        header = msghdr();
+        header.msg_name = batch.senders[senderIndex].data();
+        header.msg_namelen = static_cast<socklen_t>(batch.senders[senderIndex].size());
+        header.msg_iov = &batch.sendIovecs[i * 2];
+        header.msg_iovlen = buffers.size();
     }
-    sendResponse(*createNotFoundResponse());
+    int result = count > 0 ? sendmmsg(socket->native_handle(), batch.sendHeaders.data(),
+                                      static_cast<unsigned>(count), MSG_DONTWAIT)
+                           : 0;
+    if (result > 0)
+        sent = static_cast<size_t>(result);
+#endif
+    // Whatever the kernel didn't take right away is sent asynchronously
+    for (size_t i = sent; i < batch.responses.size(); ++i) {
+        auto& [response, senderIndex] = batch.responses[i];
+        sendUdpResponse(response, socket, batch.senders[senderIndex]);
+    }
+    batch.responses.clear();
 }
 
-std::string Webserver::getHeaderValue(const std::string& headers, const std::string& headerName) {
-    std::string lowerHeader = headerName;
-    std::transform(lowerHeader.begin(), lowerHeader.end(), lowerHeader.begin(), ::tolower);
-    size_t pos = headers.find(lowerHeader + ": ");
-    if (pos == std::string::npos)
-        return "";
-    pos += lowerHeader.length() + 2;  // Skip past the header and colon
-    size_t endPos = headers.find("\r\n", pos);
-    if (endPos == std::string::npos)
-        return headers.substr(pos);  // Return the rest if no end of line is found
-    return headers.substr(pos, endPos - pos);
+UdpBatchStats Webserver::getUdpBatchStats() const {
+    UdpBatchStats stats;
+    for (const auto& batch : m_udpBatches) {
+        stats.batches += batch->batches.load(std::memory_order_relaxed);
+        stats.datagrams += batch->datagrams.load(std::memory_order_relaxed);
+        stats.fillHistogram.resize(batch->senders.size() + 1);
+        for (size_t i = 0; i < stats.fillHistogram.size(); ++i)
+            stats.fillHistogram[i] += batch->fillHistogram[i].load(std::memory_order_relaxed);
+    }
+    return stats;
 }
 
-std::shared_ptr<HttpResponse> Webserver::handleRequest(const HttpRequest& request,
-                                                       const std::string& uriPattern) {
-    debug::log("handleRequest: uriPattern = ", uriPattern);
+CompressionStats Webserver::getCompressionStats() const {
+    return m_compressor->getStats();
+}
 
-    auto resourceIt = m_resourceMap.find(uriPattern);
-    if (resourceIt == m_resourceMap.end()) {
-        debug::log("handleRequest: Resource not found");
+void Webserver::handleRequestData(const char* data, size_t length,
+                                  std::function<void(std::shared_ptr<HttpResponse>)> sendResponse) {
+    // Datagram has to carry the whole request
+    HttpParser parser(m_maxHeaderSize, m_maxBodySize);
+    parser.parse(data, length);
+    if (parser.hasError()) {
+        sendResponse(createErrorResponse(parser.getErrorStatus()));
+        return;
+    }
+    if (!parser.isComplete()) {
+        debug::log("Incomplete request");
+        sendResponse(createBadRequestResponse());
+        return;
+    }
+    HttpRequest request = parser.takeRequest();
+    // Datagrams carry the body itself
+    sendResponse(loadBody(routeRequest(request)));
+}
+
+std::shared_ptr<HttpResource> Webserver::findResource(HttpRequest& request) {
+    Router::Match match;
+    if (!m_router.match(request.getUri(), match))
+        return nullptr;
+    debug::log("Pattern: ", match.resource->getUri(), " request: ", request.getUri());
+    for (const auto& [name, value] : match.args)
+        request.setArg(name, value);
+    return std::move(match.resource);
+}
+
+std::shared_ptr<HttpResponse> Webserver::routeRequest(HttpRequest& request) {
+    return routeRequest(request, findResource(request));
+}
+
+std::shared_ptr<HttpResponse> Webserver::routeRequest(const HttpRequest& request,
+                                                      const std::shared_ptr<HttpResource>& resource) {
+    if (!resource)
         return createNotFoundResponse();
+    const auto& compression = resource->getCompression();
+    auto response = applyRange(request, handleRequest(request, resource));
+    return m_compressor->compress(request, compression ? *compression : m_compression, std::move(response));
+}
+
+std::shared_ptr<BodyConsumer> Webserver::createBodyConsumer(const HttpRequest& request,
+                                                            const std::shared_ptr<HttpResource>& resource) {
+    if (!resource || !resource->isAllowed(request.getMethod()))
+        return nullptr;
+    auto handler = resource->getHandler();
+    if (!handler)
+        return nullptr;
+    try {
+        return handler->consumeBody(request);
+    } catch (const std::exception& e) {
+        std::cerr << "createBodyConsumer: Exception in handler: " << e.what() << std::endl;
+        return nullptr;
     }
-    auto resource = resourceIt->second;
-    auto methodHandlerIt = m_methodHandlers.find(request.getMethod());
-    if (methodHandlerIt == m_methodHandlers.end() ||
-        !resource->isAllowed(request.getMethod())) {
-        debug::log("handleRequest: Method not allowed");
-        return createMethodNotAllowed(resource->getAllowedMethodsAsString());
+}
+
+std::shared_ptr<HttpResponse> Webserver::finishBody(const HttpRequest& request, const HttpResource& resource,
+                                                    BodyConsumer& consumer) {
+    std::shared_ptr<HttpResponse> response;
+    try {
+        response = consumer.onEnd(request);
+    } catch (const std::exception& e) {
+        std::cerr << "finishBody: Exception in body consumer: " << e.what() << std::endl;
+        return createErrorResponse(HttpStatusCode::INTERNAL_SERVER_ERROR);
     }
+    if (!response)
+        return createErrorResponse(HttpStatusCode::INTERNAL_SERVER_ERROR);
+    auto cache = resource.getCache();
+    if (cache && response->getStatusCode() >= 200 && response->getStatusCode() < 300)
+        cache->invalidate(request.getUri());
+    const auto& compression = resource.getCompression();
+    return m_compressor->compress(request, compression ? *compression : m_compression, std::move(response));
+}
+
+bool Webserver::isKeepAlive(const HttpRequest& request) {
+    std::string_view connection = request.getHeader("Connection");
+    if (request.getVersion() == "HTTP/1.1")
+        return !util::equalsIgnoreCase(connection, "close");
+    // HTTP/1.0 connections are persistent only on explicit request
+    return util::equalsIgnoreCase(connection, "keep-alive");
+}
+
+std::shared_ptr<HttpResponse> Webserver::handleRequest(const HttpRequest& request,
+                                                       const std::shared_ptr<HttpResource>& resource) {
     if (!resource) {
         debug::log("handleRequest: resource is null!");
         return createBadRequestResponse();
     }
+    debug::log("handleRequest: uriPattern = ", resource->getUri());
+
+    HttpMethod method = request.getMethod();
+    if (!resource->isAllowed(method)) {
+        debug::log("handleRequest: Method not allowed");
+        return resource->getMethodNotAllowedResponse();
+    }
+    if (method == HttpMethod::HTTP_OPTIONS)
+        return resource->getOptionsResponse();
+    const MethodHandler& methodHandler = m_methodHandlers[method];
+    if (!methodHandler) {
+        debug::log("handleRequest: Method has no handler");
+        return resource->getMethodNotAllowedResponse();
+    }
 
     auto handler = resource->getHandler();
     if (!handler) {
@@ -304,7 +648,21 @@ std::shared_ptr<HttpResponse> Webserver::handleRequest(const HttpRequest& reques
     }
 
     try {
-        return methodHandlerIt->second(handler, request);
+        auto cache = resource->getCache();
+        if (!cache)
+            return methodHandler(handler, request);
+        if (method == HttpMethod::HTTP_GET || method == HttpMethod::HTTP_HEAD) {
+            auto response = cache->respond(request, [&]() { return handler->renderGET(request); });
+            if (method == HttpMethod::HTTP_HEAD && response) {
+                response = makeMutable(response);
+                response->setHeadOnly(true);
+            }
+            return response;
+        }
+        auto response = methodHandler(handler, request);
+        if (response && response->getStatusCode() >= 200 && response->getStatusCode() < 300)
+            cache->invalidate(request.getUri());
+        return response;
     } catch (const std::exception& e) {
         std::cerr << "handleRequest: Exception in method handler: " << e.what() << std::endl;
         return createBadRequestResponse();
@@ -314,21 +672,6 @@ std::shared_ptr<HttpResponse> Webserver::handleRequest(const HttpRequest& reques
     }
 }
 
-bool Webserver::matchUrl(HttpRequest& request, const std::shared_ptr<HttpResource> resource) {
-    if (!resource->getIsValid())
-        return false;
-    std::smatch matches;
-    if (std::regex_match(request.getUri(), matches, resource->getRegexUri())) {
-        // Extract parameters by looking at each submatch after the initial match
-        for (size_t i = 1; i < matches.size(); ++i)
-            if (i <= resource->getParamNames().size())
-                request.setArg(resource->getParamNames()[i - 1], matches[i].str());
-
-        return true;
-    }
-    return false;
-}
-
 Webserver::Builder& Webserver::Builder::setTcpPort(int port) {
     this->m_tcpPort = port;
     return *this;
@@ -343,23 +686,110 @@ Webserver::Builder& Webserver::Builder::setUdpOn() {
     return *this;
 }
 
+Webserver::Builder& Webserver::Builder::setUdpBatchSize(size_t size) {
+    this->m_udpBatchSize = size;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setUdpReceiveDepth(size_t depth) {
+    this->m_udpReceiveDepth = depth;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setUdpSocketCount(size_t count) {
+    this->m_udpSocketCount = count;
+    return *this;
+}
+
 Webserver::Builder& Webserver::Builder::setBufferSize(size_t size) {
     this->m_bufferSize = size;
     return *this;
 }
+Webserver::Builder& Webserver::Builder::setBufferPoolSize(size_t count) {
+    this->m_bufferPoolSize = count;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setThreadCount(size_t threadCount) {
+    this->m_threadCount = threadCount;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setShardCount(size_t shardCount) {
+    this->m_shardCount = shardCount;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setMaxRequestsPerConnection(size_t maxRequests) {
+    this->m_maxRequestsPerConnection = maxRequests;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setIdleTimeout(std::chrono::milliseconds timeout) {
+    this->m_idleTimeout = timeout;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setMaxHeaderSize(size_t size) {
+    this->m_maxHeaderSize = size;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setMaxBodySize(size_t size) {
+    this->m_maxBodySize = size;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setMaxInFlightBytes(size_t size) {
+    this->m_maxInFlightBytes = size;
+    return *this;
+}
+
+Webserver::Builder& Webserver::Builder::setCompression(CompressionConfig config) {
+    this->m_compression = config;
+    return *this;
+}
+
 Webserver::Builder& Webserver::Builder::setResource(const std::string& path,
                                                     std::shared_ptr<HttpResourceHandler> resourceHandler) {
     m_resourceMap[path] = std::make_shared<HttpResource>(resourceHandler, path);
     return *this;
 }
 
+Webserver::Builder& Webserver::Builder::setCannedResponse(const std::string& path, HttpResponse response) {
+    auto resource = std::make_shared<HttpResource>(std::make_shared<CannedResponseHandler>(std::move(response)), path);
+    resource->disallowAll();
+    resource->setAllowing(HttpMethod::HTTP_GET, true);
+    resource->setAllowing(HttpMethod::HTTP_HEAD, true);
+    resource->setAllowing(HttpMethod::HTTP_OPTIONS, true);
+    return setResource(resource);
+}
+
+Webserver::Builder& Webserver::Builder::setStaticDirectory(const std::string& prefix, const std::string& directory,
+                                                           StaticFileHandler::Config config) {
+    auto handler = std::make_shared<StaticFileHandler>(directory, std::move(config));
+    std::string root = prefix;
+    while (!root.empty() && root.back() == '/')
+        root.pop_back();
+    // The prefix itself is answered with the index file
+    for (const std::string& path : {root.empty() ? std::string("/") : root, root + "/{path:path}"}) {
+        auto resource = std::make_shared<HttpResource>(handler, path);
+        resource->disallowAll();
+        resource->setAllowing(HttpMethod::HTTP_GET, true);
+        resource->setAllowing(HttpMethod::HTTP_HEAD, true);
+        resource->setAllowing(HttpMethod::HTTP_OPTIONS, true);
+        setResource(resource);
+    }
+    return *this;
+}
+
 Webserver::Builder& Webserver::Builder::setResource(std::shared_ptr<HttpResource> resource) {
     m_resourceMap[resource->getUri()] = resource;
     return *this;
 }
 
 Webserver Webserver::Builder::build() {
-    return Webserver(m_tcpPort, m_udpPort, m_isUdpOn, std::move(m_resourceMap), m_bufferSize);
+    return Webserver(*this);
 }
 
 }  // namespace ioteye
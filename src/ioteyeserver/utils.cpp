@@ -24,6 +24,8 @@ SOFTWARE.
 
 #include "ioteyeserver/utils.hpp"
 
+#include <cctype>
+
 namespace ioteye::util {
 std::vector<std::string> splitString(const std::string& str, char delimiter) {
     std::vector<std::string> result;
@@ -35,17 +37,31 @@ std::vector<std::string> splitString(const std::string& str, char delimiter) {
     return result;
 }
 
-HttpMethod stringToHttpMethod(const std::string& httpMethodName) {
-    static std::unordered_map<std::string, HttpMethod> stringToHttpMethod_map = {
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size())
+        return false;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(lhs[i])) != std::tolower(static_cast<unsigned char>(rhs[i])))
+            return false;
+    }
+    return true;
+}
+
+HttpMethod stringToHttpMethod(std::string_view httpMethodName) {
+    static std::unordered_map<std::string_view, HttpMethod> stringToHttpMethod_map = {
         {"GET", HttpMethod::HTTP_GET},
         {"POST", HttpMethod::HTTP_POST},
         {"PUT", HttpMethod::HTTP_PUT},
         {"DELETE", HttpMethod::HTTP_DELETE},
+        {"HEAD", HttpMethod::HTTP_HEAD},
+        {"OPTIONS", HttpMethod::HTTP_OPTIONS},
+        {"PATCH", HttpMethod::HTTP_PATCH},
     };
-    if (stringToHttpMethod_map.find(httpMethodName) == stringToHttpMethod_map.end())
+    auto it = stringToHttpMethod_map.find(httpMethodName);
+    if (it == stringToHttpMethod_map.end())
         return HttpMethod::UNKNOWN;
     else
-        return stringToHttpMethod_map[httpMethodName];
+        return it->second;
 }
 
 std::string httpMethodToString(HttpMethod_t httpMethodCode) {
@@ -54,6 +70,9 @@ std::string httpMethodToString(HttpMethod_t httpMethodCode) {
         {HttpMethod::HTTP_POST, "POST"},
         {HttpMethod::HTTP_PUT, "PUT"},
         {HttpMethod::HTTP_DELETE, "DELETE"},
+        {HttpMethod::HTTP_HEAD, "HEAD"},
+        {HttpMethod::HTTP_OPTIONS, "OPTIONS"},
+        {HttpMethod::HTTP_PATCH, "PATCH"},
     };
     if (httpMethodToString_map.find(httpMethodCode) == httpMethodToString_map.end())
         return "UNKNOWN";
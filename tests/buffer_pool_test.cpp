@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <ioteyeserver.hpp>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace ioteye;
+
+TEST(BufferPoolTest, ReusesReturnedBuffers) {
+    auto pool = std::make_shared<BufferPool>(64, 2);
+    char* first = nullptr;
+    {
+        BufferPool::Lease lease = pool->acquire();
+        ASSERT_TRUE(lease);
+        EXPECT_EQ(lease.size(), 64u);
+        first = lease.data();
+        EXPECT_EQ(pool->getStats().inUse, 1u);
+    }
+    EXPECT_EQ(pool->getStats().inUse, 0u);
+    BufferPool::Lease again = pool->acquire();
+    EXPECT_EQ(again.data(), first);
+    EXPECT_EQ(pool->getStats().hits, 2u);
+    EXPECT_EQ(pool->getStats().misses, 0u);
+}
+
+TEST(BufferPoolTest, CountsMissesWhenExhausted) {
+    auto pool = std::make_shared<BufferPool>(16, 2);
+    std::vector<BufferPool::Lease> leases;
+    for (int i = 0; i < 3; ++i)
+        leases.push_back(pool->acquire());
+    std::set<char*> distinct;
+    for (const auto& lease : leases)
+        distinct.insert(lease.data());
+    EXPECT_EQ(distinct.size(), 3u);
+    EXPECT_EQ(pool->getStats().hits, 2u);
+    EXPECT_EQ(pool->getStats().misses, 1u);
+    leases.clear();
+    EXPECT_EQ(pool->getStats().inUse, 0u);
+}
+
+TEST(BufferPoolTest, ConcurrentLeasesNeverShareBuffer) {
+    auto pool = std::make_shared<BufferPool>(8, 4);
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed{false};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, &failed, t]() {
+            for (int i = 0; i < 10000; ++i) {
+                BufferPool::Lease lease = pool->acquire();
+                std::fill(lease.data(), lease.data() + lease.size(),
+                          static_cast<char>(t));
+                for (size_t j = 0; j < lease.size(); ++j) {
+                    if (lease.data()[j] != static_cast<char>(t))
+                        failed = true;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_FALSE(failed);
+    EXPECT_EQ(pool->getStats().inUse, 0u);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "ioteyeserver/httpserver/byte_range.hpp"
+#include "test_helpers.hpp"
+
+namespace ioteye {
+namespace {
+std::shared_ptr<HttpResponse> makeResponse(const std::string& body) {
+    auto response = std::make_shared<HttpResponse>(HttpStatusCode::OK);
+    response->setContentType("application/octet-stream");
+    response->setHeader("Accept-Ranges", "bytes");
+    response->setHeader("ETag", "\"5f3a-10\"");
+    response->setHeader("Last-Modified", "Sun, 06 Nov 1994 08:49:37 GMT");
+    response->setBody(body);
+    return response;
+}
+}  // namespace
+
+TEST(ByteRangeTest, ParsesSingleRanges) {
+    ByteRange range;
+    EXPECT_EQ(util::parseRange("bytes=0-99", 1000, range), util::RangeStatus::SATISFIABLE);
+    EXPECT_EQ(range.offset, 0u);
+    EXPECT_EQ(range.length, 100u);
+    EXPECT_EQ(util::parseRange("bytes=900-", 1000, range), util::RangeStatus::SATISFIABLE);
+    EXPECT_EQ(range.offset, 900u);
+    EXPECT_EQ(range.length, 100u);
+    EXPECT_EQ(util::parseRange("bytes=-200", 1000, range), util::RangeStatus::SATISFIABLE);
+    EXPECT_EQ(range.offset, 800u);
+    EXPECT_EQ(range.length, 200u);
+    // The last position is clamped to the end of the body
+    EXPECT_EQ(util::parseRange("bytes=990-5000", 1000, range), util::RangeStatus::SATISFIABLE);
+    EXPECT_EQ(range.offset, 990u);
+    EXPECT_EQ(range.length, 10u);
+    EXPECT_EQ(util::parseRange("bytes=-5000", 1000, range), util::RangeStatus::SATISFIABLE);
+    EXPECT_EQ(range.offset, 0u);
+    EXPECT_EQ(range.length, 1000u);
+}
+
+TEST(ByteRangeTest, IgnoresUnsupportedRanges) {
+    ByteRange range;
+    EXPECT_EQ(util::parseRange("bytes=0-9,20-29", 1000, range), util::RangeStatus::IGNORED);
+    EXPECT_EQ(util::parseRange("items=0-9", 1000, range), util::RangeStatus::IGNORED);
+    EXPECT_EQ(util::parseRange("bytes=9-0", 1000, range), util::RangeStatus::IGNORED);
+    EXPECT_EQ(util::parseRange("bytes=a-9", 1000, range), util::RangeStatus::IGNORED);
+    EXPECT_EQ(util::parseRange("bytes=", 1000, range), util::RangeStatus::IGNORED);
+    EXPECT_EQ(util::parseRange("bytes=1000-", 1000, range), util::RangeStatus::UNSATISFIABLE);
+    EXPECT_EQ(util::parseRange("bytes=-0", 1000, range), util::RangeStatus::UNSATISFIABLE);
+}
+
+TEST(ByteRangeTest, MatchesIfRange) {
+    EXPECT_TRUE(util::ifRangeMatches("\"5f3a-10\"", "\"5f3a-10\"", ""));
+    EXPECT_FALSE(util::ifRangeMatches("\"5f3a-11\"", "\"5f3a-10\"", ""));
+    EXPECT_FALSE(util::ifRangeMatches("W/\"5f3a-10\"", "W/\"5f3a-10\"", ""));
+    EXPECT_TRUE(util::ifRangeMatches("Sun, 06 Nov 1994 08:49:37 GMT", "", "Sun, 06 Nov 1994 08:49:37 GMT"));
+    EXPECT_FALSE(util::ifRangeMatches("Sun, 06 Nov 1994 08:49:38 GMT", "", "Sun, 06 Nov 1994 08:49:37 GMT"));
+}
+
+TEST(ByteRangeTest, AnswersPartialContent) {
+    auto response = applyRange(makeRequest("/firmware.bin", "Range: bytes=2-5\r\n"), makeResponse("0123456789"));
+    EXPECT_EQ(response->getStatusCode(), HttpStatusCode::PARTIAL_CONTENT);
+    EXPECT_EQ(response->getHeader("Content-Range"), "bytes 2-5/10");
+    EXPECT_EQ(response->getBody(), "2345");
+    EXPECT_NE(response->toString().find("Content-Length: 4\r\n"), std::string::npos);
+}
+
+TEST(ByteRangeTest, AnswersUnsatisfiableRange) {
+    auto response = applyRange(makeRequest("/firmware.bin", "Range: bytes=10-\r\n"), makeResponse("0123456789"));
+    EXPECT_EQ(response->getStatusCode(), HttpStatusCode::RANGE_NOT_SATISFIABLE);
+    EXPECT_EQ(response->getHeader("Content-Range"), "bytes */10");
+    // The canned 416 itself stays untouched
+    EXPECT_TRUE(createErrorResponse(HttpStatusCode::RANGE_NOT_SATISFIABLE)->getHeader("Content-Range").empty());
+}
+
+TEST(ByteRangeTest, SendsWholeBodyWhenIfRangeDiffers) {
+    auto whole = makeResponse("0123456789");
+    auto response = applyRange(makeRequest("/firmware.bin", "Range: bytes=2-5\r\nIf-Range: \"5f3a-11\"\r\n"), whole);
+    EXPECT_EQ(response, whole);
+    response = applyRange(makeRequest("/firmware.bin", "Range: bytes=2-5\r\nIf-Range: \"5f3a-10\"\r\n"), whole);
+    EXPECT_EQ(response->getStatusCode(), HttpStatusCode::PARTIAL_CONTENT);
+}
+
+TEST(ByteRangeTest, LeavesOtherResponsesAlone) {
+    auto plain = std::make_shared<HttpResponse>(HttpStatusCode::OK);
+    plain->setBody("0123456789");
+    EXPECT_EQ(applyRange(makeRequest("/firmware.bin", "Range: bytes=2-5\r\n"), plain), plain);
+    auto encoded = makeResponse("0123456789");
+    encoded->setHeader("Content-Encoding", "gzip");
+    EXPECT_EQ(applyRange(makeRequest("/firmware.bin", "Range: bytes=2-5\r\n"), encoded), encoded);
+    auto whole = makeResponse("0123456789");
+    EXPECT_EQ(applyRange(makeRequest("/firmware.bin"), whole), whole);
+}
+
+TEST(ByteRangeTest, NarrowsFileBodies) {
+    auto path = std::filesystem::temp_directory_path() / "ioteye_byte_range_firmware.bin";
+    std::string image;
+    for (int i = 0; i < 4096; ++i)
+        image += static_cast<char>('a' + i % 26);
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << image;
+
+    auto file = FileBody::open(path.string());
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(file->getSize(), image.size());
+    auto response = std::make_shared<HttpResponse>(HttpStatusCode::OK);
+    response->setFileBody(file);
+    response = applyRange(makeRequest("/firmware.bin", "Range: bytes=1000-1999\r\n"), response);
+    EXPECT_EQ(response->getStatusCode(), HttpStatusCode::PARTIAL_CONTENT);
+    EXPECT_EQ(response->getHeader("Content-Range"), "bytes 1000-1999/4096");
+    EXPECT_EQ(response->getFileBody(), file);
+    EXPECT_EQ(response->getFileOffset(), 1000u);
+    EXPECT_EQ(response->getBodySize(), 1000u);
+    EXPECT_EQ(response->getBody(), image.substr(1000, 1000));
+    std::filesystem::remove(path);
+}
+}  // namespace ioteye
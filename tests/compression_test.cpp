@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <memory>
+#include <string>
+
+#include "ioteyeserver/httpserver/compression.hpp"
+#include "test_helpers.hpp"
+
+namespace ioteye {
+namespace {
+std::string inflateBody(std::string_view data, ContentEncoding encoding) {
+    z_stream stream{};
+    inflateInit2(&stream, encoding == ContentEncoding::GZIP ? 15 + 16 : 15);
+    std::string out(64 * 1024, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = inflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END ? out : "inflate failed";
+}
+
+std::string makeJson(size_t readings) {
+    std::string json = "[";
+    for (size_t i = 0; i < readings; ++i)
+        json += "{\"sensor\":\"temperature\",\"value\":" + std::to_string(20 + i % 5) + "},";
+    json.back() = ']';
+    return json;
+}
+
+std::shared_ptr<HttpResponse> makeJsonResponse() {
+    auto response = std::make_shared<HttpResponse>(200, makeJson(100));
+    response->setContentType("application/json");
+    return response;
+}
+}  // namespace
+
+TEST(CompressionTest, NegotiatesEncoding) {
+    EXPECT_EQ(util::negotiateContentEncoding(""), ContentEncoding::IDENTITY);
+    EXPECT_EQ(util::negotiateContentEncoding("gzip"), ContentEncoding::GZIP);
+    EXPECT_EQ(util::negotiateContentEncoding("deflate, gzip"), ContentEncoding::GZIP);
+    EXPECT_EQ(util::negotiateContentEncoding("deflate"), ContentEncoding::DEFLATE);
+    EXPECT_EQ(util::negotiateContentEncoding("gzip;q=0.5, deflate"), ContentEncoding::DEFLATE);
+    EXPECT_EQ(util::negotiateContentEncoding("GZIP ; Q=0.8, deflate;q=0.3"), ContentEncoding::GZIP);
+    EXPECT_EQ(util::negotiateContentEncoding("gzip;q=0, deflate;q=0"), ContentEncoding::IDENTITY);
+    EXPECT_EQ(util::negotiateContentEncoding("br, identity"), ContentEncoding::IDENTITY);
+    EXPECT_EQ(util::negotiateContentEncoding("*"), ContentEncoding::GZIP);
+    EXPECT_EQ(util::negotiateContentEncoding("gzip;q=0, *"), ContentEncoding::DEFLATE);
+}
+
+TEST(CompressionTest, RecognizesCompressibleTypes) {
+    EXPECT_TRUE(util::isCompressibleType("text/plain"));
+    EXPECT_TRUE(util::isCompressibleType("text/html; charset=utf-8"));
+    EXPECT_TRUE(util::isCompressibleType("application/json"));
+    EXPECT_TRUE(util::isCompressibleType("application/vnd.api+json"));
+    EXPECT_TRUE(util::isCompressibleType("image/svg+xml"));
+    EXPECT_FALSE(util::isCompressibleType("image/png"));
+    EXPECT_FALSE(util::isCompressibleType("application/octet-stream"));
+    EXPECT_FALSE(util::isCompressibleType(""));
+}
+
+TEST(CompressionTest, CompressesRoundTrip) {
+    std::string json = makeJson(100);
+    for (ContentEncoding encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+        std::string compressed = util::compress(json, encoding, 6);
+        EXPECT_LT(compressed.size(), json.size());
+        EXPECT_EQ(inflateBody(compressed, encoding), json);
+    }
+    EXPECT_EQ(util::compress(json, ContentEncoding::IDENTITY, 6), "");
+}
+
+TEST(CompressionTest, CompressesAcceptedResponses) {
+    ResponseCompressor compressor;
+    auto original = makeJsonResponse();
+    original->setHeader("ETag", "\"abc\"");
+    auto response =
+        compressor.compress(makeRequest("/readings", "Accept-Encoding: gzip"), CompressionConfig{}, original);
+    EXPECT_EQ(response->getHeader("Content-Encoding"), "gzip");
+    EXPECT_EQ(response->getHeader("Vary"), "Accept-Encoding");
+    EXPECT_EQ(response->getHeader("ETag"), "W/\"abc\"");
+    EXPECT_EQ(inflateBody(response->getBodyView(), ContentEncoding::GZIP), original->getBody());
+    // The handler's response is left alone
+    EXPECT_EQ(original->getHeader("Content-Encoding"), "");
+
+    CompressionStats stats = compressor.getStats();
+    EXPECT_EQ(stats.responses, 1u);
+    EXPECT_EQ(stats.compressions, 1u);
+    EXPECT_EQ(stats.bytesIn, original->getBodyView().size());
+    EXPECT_EQ(stats.bytesOut, response->getBodyView().size());
+}
+
+TEST(CompressionTest, SkipsWhatIsNotWorthIt) {
+    ResponseCompressor compressor;
+    CompressionConfig config;
+    auto gzipRequest = makeRequest("/readings", "Accept-Encoding: gzip");
+    auto response = makeJsonResponse();
+    EXPECT_EQ(compressor.compress(makeRequest("/readings"), config, response), response);
+
+    auto small = std::make_shared<HttpResponse>(200, "tiny");
+    EXPECT_EQ(compressor.compress(gzipRequest, config, small), small);
+
+    auto image = std::make_shared<HttpResponse>(200, std::string(4096, 'x'));
+    image->setContentType("image/png");
+    EXPECT_EQ(compressor.compress(gzipRequest, config, image), image);
+
+    auto head = makeJsonResponse();
+    head->setHeadOnly(true);
+    EXPECT_EQ(compressor.compress(gzipRequest, config, head), head);
+
+    config.enabled = false;
+    EXPECT_EQ(compressor.compress(gzipRequest, config, response), response);
+    EXPECT_EQ(compressor.getStats().compressions, 0u);
+}
+
+TEST(CompressionTest, AppliesLevel) {
+    ResponseCompressor compressor;
+    CompressionConfig fastest;
+    fastest.level = 1;
+    CompressionConfig smallest;
+    smallest.level = 9;
+    auto request = makeRequest("/readings", "Accept-Encoding: deflate");
+    auto fast = compressor.compress(request, fastest, makeJsonResponse());
+    auto small = compressor.compress(request, smallest, makeJsonResponse());
+    EXPECT_EQ(fast->getHeader("Content-Encoding"), "deflate");
+    EXPECT_LE(small->getBodyView().size(), fast->getBodyView().size());
+}
+
+TEST(CompressionTest, KeepsCannedVariants) {
+    ResponseCompressor compressor;
+    HttpResponse json(200, makeJson(100));
+    json.setContentType("application/json");
+    CannedResponse canned(json);
+    auto request = makeRequest("/readings", "Accept-Encoding: gzip");
+    auto first = compressor.compress(request, CompressionConfig{}, canned.get());
+    auto second = compressor.compress(request, CompressionConfig{}, canned.get());
+    EXPECT_TRUE(second->isCanned());
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(second->getHeader("Content-Encoding"), "gzip");
+    EXPECT_EQ(compressor.getStats().compressions, 1u);
+    EXPECT_EQ(compressor.getStats().responses, 2u);
+
+    auto deflated =
+        compressor.compress(makeRequest("/readings", "Accept-Encoding: deflate"), CompressionConfig{}, canned.get());
+    EXPECT_EQ(deflated->getHeader("Content-Encoding"), "deflate");
+    EXPECT_EQ(compressor.getStats().compressions, 2u);
+    // A mutable copy may change the body, so it doesn't take the variants along
+    EXPECT_EQ(makeMutable(canned.get())->getCompressedVariants(), nullptr);
+}
+}  // namespace ioteye
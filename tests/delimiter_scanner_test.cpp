@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <ioteyeserver.hpp>
+#include <random>
+#include <string>
+
+using namespace ioteye;
+
+TEST(DelimiterScannerTest, FindsDelimitersAndControlCharacters) {
+    std::string line = "GET /devices/12?full=1 HTTP/1.1";
+    EXPECT_EQ(DelimiterScanner::find(line.data(), line.size(), " "), 3u);
+    EXPECT_EQ(DelimiterScanner::find(line.data() + 4, line.size() - 4, " ?"), 11u);
+    EXPECT_EQ(DelimiterScanner::find(line.data(), line.size(), "#"), line.size());
+
+    std::string header = "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\tGecko\r\n";
+    EXPECT_EQ(DelimiterScanner::find(header.data(), header.size(), ":"), 10u);
+    // Tab is allowed, carriage return stops the scan
+    EXPECT_EQ(DelimiterScanner::find(header.data(), header.size(), ""), header.size() - 2);
+    std::string withDel = std::string(40, 'a') + "\x7f";
+    EXPECT_EQ(DelimiterScanner::find(withDel.data(), withDel.size(), ""), 40u);
+    std::string utf8 = "name: \xd0\xb7\xd0\xbd\xd0\xb0\xd1\x87\xd0\xb5\xd0\xbd\xd0\xb8\xd0\xb5 value\n";
+    EXPECT_EQ(DelimiterScanner::find(utf8.data(), utf8.size(), ""), utf8.size() - 1);
+}
+
+TEST(DelimiterScannerTest, MatchesScalarScan) {
+    std::mt19937 random(42);
+    const std::string alphabet = "abcXYZ019 :?/-\t\r\n\x01\x7f\x80\xff";
+    for (int round = 0; round < 2000; ++round) {
+        std::string data(random() % 100, 'x');
+        for (auto& c : data)
+            c = random() % 8 == 0 ? alphabet[random() % alphabet.size()] : 'a' + random() % 26;
+        for (std::string_view delimiters : {"", ":", " ?", "\n:? "}) {
+            ASSERT_EQ(DelimiterScanner::find(data.data(), data.size(), delimiters),
+                      DelimiterScanner::findScalar(data.data(), data.size(), delimiters))
+                << DelimiterScanner::getImplementationName();
+        }
+    }
+}
+
+TEST(DelimiterScannerTest, ValidatesTokens) {
+    std::string line = "X-Device_Id.v2: 1";
+    EXPECT_EQ(DelimiterScanner::findTokenEnd(line.data(), line.size()), 14u);
+    EXPECT_FALSE(DelimiterScanner::isTokenChar(' '));
+    EXPECT_FALSE(DelimiterScanner::isTokenChar('('));
+    EXPECT_TRUE(DelimiterScanner::isTokenChar('~'));
+}
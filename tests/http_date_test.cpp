@@ -0,0 +1,23 @@
+#include <gtest/gtest.h>
+
+#include <ioteyeserver.hpp>
+
+using namespace ioteye;
+
+TEST(HttpDateTest, FormatsImfFixdate) {
+    EXPECT_EQ(HttpDate::format(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+    EXPECT_EQ(HttpDate::format(0), "Thu, 01 Jan 1970 00:00:00 GMT");
+}
+
+TEST(HttpDateTest, NowFollowsClockWithAndWithoutTicks) {
+    std::string before = HttpDate::format(std::time(nullptr));
+    std::string now(HttpDate::now());
+    std::string after = HttpDate::format(std::time(nullptr));
+    EXPECT_TRUE(now == before || now == after);
+
+    HttpDate::tick();
+    now = std::string(HttpDate::now());
+    after = HttpDate::format(std::time(nullptr));
+    EXPECT_TRUE(now == before || now == after);
+    HttpDate::stopTicking();
+}
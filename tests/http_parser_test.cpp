@@ -0,0 +1,256 @@
+#include <gtest/gtest.h>
+
+#include <ioteyeserver.hpp>
+
+using namespace ioteye;
+
+TEST(HttpParserTest, ParsesCompleteRequest) {
+    HttpParser parser;
+    std::string data =
+        "POST /test/ HTTP/1.1\r\nHost: localhost\r\nContent-Length: 4\r\n\r\nbody";
+    EXPECT_EQ(parser.parse(data.data(), data.size()), data.size());
+    ASSERT_TRUE(parser.isComplete());
+
+    HttpRequest request = parser.takeRequest();
+    EXPECT_EQ(request.getMethod(), HttpMethod::HTTP_POST);
+    EXPECT_EQ(request.getUri(), "/test");
+    EXPECT_EQ(request.getVersion(), "HTTP/1.1");
+    EXPECT_EQ(request.getHeaders(), "Host: localhost\r\nContent-Length: 4");
+    EXPECT_EQ(request.getHeader("host"), "localhost");
+    EXPECT_EQ(request.getHeader("Content-length"), "4");
+    EXPECT_EQ(request.getBody(), "body");
+    EXPECT_FALSE(parser.isStarted());
+}
+
+TEST(HttpParserTest, ParsesRequestSplitIntoSingleBytes) {
+    HttpParser parser;
+    std::string data =
+        "PUT /test/1 HTTP/1.1\r\nContent-Length: 11\r\n\r\nHello World";
+    for (size_t i = 0; i < data.size(); ++i) {
+        ASSERT_FALSE(parser.isComplete());
+        EXPECT_EQ(parser.parse(data.data() + i, 1), 1);
+    }
+    ASSERT_TRUE(parser.isComplete());
+    HttpRequest request = parser.takeRequest();
+    EXPECT_EQ(request.getUri(), "/test/1");
+    EXPECT_EQ(request.getBody(), "Hello World");
+}
+
+TEST(HttpParserTest, ViewsSinglePieceAndCopiesSplitOne) {
+    {
+        HttpParser parser;
+        std::string data = "POST /a HTTP/1.1\r\nHost: localhost\r\nContent-Length: 2\r\n\r\nok";
+        parser.parse(data.data(), data.size());
+        ASSERT_TRUE(parser.isComplete());
+        HttpRequest request = parser.takeRequest();
+        EXPECT_EQ(request.getUri().data(), data.data() + 5);
+        EXPECT_EQ(request.getHeader("Host").data(), data.data() + 24);
+        EXPECT_EQ(request.getBody().data(), data.data() + data.size() - 2);
+    }
+    {
+        // Every piece is overwritten once parsed, like a reused read buffer
+        HttpParser parser;
+        std::string data = "POST /a HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n\r\nhello";
+        size_t split = data.find("Content");
+        std::string buffer = data.substr(0, split);
+        parser.parse(buffer.data(), buffer.size());
+        buffer.assign(buffer.size(), '#');
+        buffer = data.substr(split, data.size() - split - 2);
+        parser.parse(buffer.data(), buffer.size());
+        buffer.assign(buffer.size(), '#');
+        buffer = data.substr(data.size() - 2);
+        parser.parse(buffer.data(), buffer.size());
+        ASSERT_TRUE(parser.isComplete());
+        HttpRequest request = parser.takeRequest();
+        buffer.assign(buffer.size(), '#');
+        EXPECT_EQ(request.getUri(), "/a");
+        EXPECT_EQ(request.getVersion(), "HTTP/1.1");
+        EXPECT_EQ(request.getHeader("Host"), "localhost");
+        EXPECT_EQ(request.getHeader("Content-Length"), "5");
+        EXPECT_EQ(request.getBody(), "hello");
+    }
+}
+
+TEST(HttpParserTest, SplitsQueryFromPath) {
+    HttpParser parser;
+    std::string data = "GET /devices/7/?rate=10&unit=c HTTP/1.1\r\n\r\n";
+    parser.parse(data.data(), data.size());
+    ASSERT_TRUE(parser.isComplete());
+    HttpRequest request = parser.takeRequest();
+    EXPECT_EQ(request.getUri(), "/devices/7");
+    EXPECT_EQ(request.getQuery(), "rate=10&unit=c");
+    EXPECT_EQ(request.getQueryParam<int>("rate"), 10);
+
+    data = "GET /devices? HTTP/1.1\r\n\r\n";
+    parser.parse(data.data(), data.size());
+    ASSERT_TRUE(parser.isComplete());
+    request = parser.takeRequest();
+    EXPECT_EQ(request.getUri(), "/devices");
+    EXPECT_TRUE(request.getQuery().empty());
+
+    data = "GET ?rate=10 HTTP/1.1\r\n\r\n";
+    parser.parse(data.data(), data.size());
+    EXPECT_TRUE(parser.hasError());
+}
+
+TEST(HttpParserTest, StopsAfterContentLength) {
+    HttpParser parser;
+    std::string first = "POST /a HTTP/1.1\r\nContent-Length: 2\r\n\r\nok";
+    std::string second = "GET /b HTTP/1.1\r\n\r\n";
+    std::string data = first + second;
+
+    size_t consumed = parser.parse(data.data(), data.size());
+    EXPECT_EQ(consumed, first.size());
+    ASSERT_TRUE(parser.isComplete());
+    EXPECT_EQ(parser.takeRequest().getBody(), "ok");
+
+    parser.parse(data.data() + consumed, data.size() - consumed);
+    ASSERT_TRUE(parser.isComplete());
+    HttpRequest request = parser.takeRequest();
+    EXPECT_EQ(request.getUri(), "/b");
+    EXPECT_TRUE(request.getBody().empty());
+}
+
+TEST(HttpParserTest, RejectsMalformedRequests) {
+    {
+        HttpParser parser;
+        std::string data = "GET\r\n\r\n";
+        parser.parse(data.data(), data.size());
+        EXPECT_TRUE(parser.hasError());
+        EXPECT_EQ(parser.getErrorStatus(), HttpStatusCode::BAD_REQUEST);
+    }
+    {
+        HttpParser parser;
+        std::string data = "GET / HTTP/1.1\r\nContent-Length: abc\r\n\r\n";
+        parser.parse(data.data(), data.size());
+        EXPECT_TRUE(parser.hasError());
+        EXPECT_EQ(parser.getErrorStatus(), HttpStatusCode::BAD_REQUEST);
+    }
+    {
+        HttpParser parser;
+        std::string data = "GET / HTTP/2.0\r\n\r\n";
+        parser.parse(data.data(), data.size());
+        EXPECT_EQ(parser.getErrorStatus(),
+                  HttpStatusCode::HTTP_VERSION_NOT_SUPPORTED);
+    }
+}
+
+TEST(HttpParserTest, RejectsControlCharacters) {
+    const std::string requests[] = {
+        "GET / HTTP/1.1\r\nHost: a\x01b\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost: a\rb\r\n\r\n",
+        "GET / HTTP/1.1\r\nHo st: a\r\n\r\n",
+        "GET / HTTP/1.1\r\n folded: a\r\n\r\n",
+        "G(T / HTTP/1.1\r\n\r\n",
+    };
+    for (const auto& data : requests) {
+        HttpParser parser;
+        parser.parse(data.data(), data.size());
+        EXPECT_TRUE(parser.hasError()) << data;
+        EXPECT_EQ(parser.getErrorStatus(), HttpStatusCode::BAD_REQUEST);
+    }
+    // Carriage return split from its line feed by a read
+    HttpParser parser;
+    std::string first = "GET / HTTP/1.1\r";
+    std::string second = "\nUser-Agent: x\tx\r\n\r\n";
+    parser.parse(first.data(), first.size());
+    parser.parse(second.data(), second.size());
+    ASSERT_TRUE(parser.isComplete());
+    EXPECT_EQ(parser.takeRequest().getHeader("User-Agent"), "x\tx");
+}
+
+TEST(HttpParserTest, EnforcesLimits) {
+    {
+        HttpParser parser(32);
+        std::string data = "GET / HTTP/1.1\r\nX-Long: " +
+                           std::string(64, 'a') + "\r\n\r\n";
+        parser.parse(data.data(), data.size());
+        EXPECT_EQ(parser.getErrorStatus(),
+                  HttpStatusCode::REQUEST_HEADER_FIELDS_TOO_LARGE);
+    }
+    {
+        HttpParser parser(8192, 4);
+        std::string data = "POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\n";
+        parser.parse(data.data(), data.size());
+        EXPECT_EQ(parser.getErrorStatus(), HttpStatusCode::PAYLOAD_TOO_LARGE);
+    }
+}
+
+TEST(HttpParserTest, DecodesChunkedBody) {
+    std::string data =
+        "POST /logs HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "5\r\nHello\r\n6;name=value\r\n World\r\n0\r\nX-Checksum: 1f\r\n\r\n"
+        "GET /next HTTP/1.1\r\n\r\n";
+    size_t requestSize = data.find("GET");
+    {
+        HttpParser parser;
+        EXPECT_EQ(parser.parse(data.data(), data.size()), requestSize);
+        ASSERT_TRUE(parser.isComplete());
+        HttpRequest request = parser.takeRequest();
+        EXPECT_EQ(request.getBody(), "Hello World");
+        // Trailer fields are dropped
+        EXPECT_EQ(request.getHeader("X-Checksum"), "");
+    }
+    {
+        HttpParser parser;
+        for (size_t i = 0; i < requestSize; ++i) {
+            ASSERT_FALSE(parser.isComplete());
+            EXPECT_EQ(parser.parse(data.data() + i, 1), 1);
+        }
+        ASSERT_TRUE(parser.isComplete());
+        EXPECT_EQ(parser.takeRequest().getBody(), "Hello World");
+    }
+}
+
+TEST(HttpParserTest, RejectsMalformedChunkedBodies) {
+    const std::pair<std::string, HttpStatusCode> requests[] = {
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", HttpStatusCode::NOT_IMPLEMENTED},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 5\r\n\r\n", HttpStatusCode::BAD_REQUEST},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", HttpStatusCode::BAD_REQUEST},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nabc\r\n", HttpStatusCode::BAD_REQUEST},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nffffffffffffffffff\r\n", HttpStatusCode::BAD_REQUEST},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\n", HttpStatusCode::PAYLOAD_TOO_LARGE},
+    };
+    for (const auto& [data, status] : requests) {
+        HttpParser parser(8192, 4);
+        parser.parse(data.data(), data.size());
+        EXPECT_TRUE(parser.hasError()) << data;
+        EXPECT_EQ(parser.getErrorStatus(), status) << data;
+    }
+}
+
+TEST(HttpParserTest, PassesBodyToConsumer) {
+    HttpParser parser(8192, 4);
+    std::string received;
+    bool isPaused = false;
+    parser.setHeadCallback([&](HttpRequest& request) {
+        EXPECT_EQ(request.getUri(), "/logs");
+        parser.setBodyConsumer([&](std::string_view data) {
+            received += data;
+            // Pauses after every piece which ends a line
+            return !(isPaused = !data.empty() && data.back() == '\n');
+        });
+    });
+    std::string data =
+        "POST /logs HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "6\r\nboot\r\n\r\n7\r\nready\r\n\r\n0\r\n\r\n";
+    // The body limit doesn't apply to consumed bodies
+    size_t consumed = parser.parse(data.data(), data.size());
+    EXPECT_TRUE(isPaused);
+    EXPECT_EQ(received, "boot\r\n");
+    consumed += parser.parse(data.data() + consumed, data.size() - consumed);
+    EXPECT_EQ(received, "boot\r\nready\r\n");
+    consumed += parser.parse(data.data() + consumed, data.size() - consumed);
+    EXPECT_EQ(consumed, data.size());
+    ASSERT_TRUE(parser.isComplete());
+    HttpRequest request = parser.takeRequest();
+    EXPECT_EQ(request.getUri(), "/logs");
+    EXPECT_TRUE(request.getBody().empty());
+
+    // The consumer is set for one request only
+    std::string next = "POST /logs HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc";
+    parser.setHeadCallback(nullptr);
+    parser.parse(next.data(), next.size());
+    ASSERT_TRUE(parser.isComplete());
+    EXPECT_EQ(parser.takeRequest().getBody(), "abc");
+}
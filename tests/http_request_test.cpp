@@ -10,6 +10,19 @@ TEST(HttpRequestTest, SetAndGetArg) {
     EXPECT_EQ(request.getArg("key"), "value");
 }
 
+TEST(HttpRequestTest, GetTypedArg) {
+    HttpRequest request;
+    request.setArg("id", "-42");
+    request.setArg("ts", "18446744073709551615");
+    request.setArg("name", "sensor1");
+    EXPECT_EQ(request.getArg<int64_t>("id"), -42);
+    EXPECT_EQ(request.getArg<uint64_t>("ts"), 18446744073709551615ull);
+    EXPECT_FALSE(request.getArg<int64_t>("ts").has_value());
+    EXPECT_FALSE(request.getArg<uint64_t>("id").has_value());
+    EXPECT_FALSE(request.getArg<int>("name").has_value());
+    EXPECT_FALSE(request.getArg<int>("missing").has_value());
+}
+
 TEST(HttpRequestTest, ClearArgs) {
     HttpRequest request;
     request.setArg("key1", "value1");
@@ -36,8 +49,91 @@ TEST(HttpRequestTest, SetAndGetHeaders) {
     EXPECT_EQ(request.getHeaders(), "Content-Type: text/html");
 }
 
+TEST(HttpRequestTest, GetHeaderIgnoresCase) {
+    HttpRequest request;
+    request.setHeaders("content-type: text/html\r\nX-Device-Id:  lamp1 \r\nHOST: a\r\nHost: b\r\nEmpty:");
+    EXPECT_EQ(request.getHeader("Content-Type"), "text/html");
+    EXPECT_EQ(request.getHeader("x-device-id"), "lamp1");
+    EXPECT_EQ(request.getHeader("host"), "a");
+    EXPECT_TRUE(request.hasHeader("empty"));
+    EXPECT_EQ(request.getHeader("Empty"), "");
+    EXPECT_FALSE(request.hasHeader("Connection"));
+    EXPECT_FALSE(request.hasHeader("X-Other"));
+
+    request.addHeader("Connection", "close");
+    EXPECT_EQ(request.getHeader("CONNECTION"), "close");
+    EXPECT_EQ(request.getHeader("Content-Type"), "text/html");
+}
+
 TEST(HttpRequestTest, SetAndGetBody) {
     HttpRequest request;
     request.setBody("Hello, World!");
     EXPECT_EQ(request.getBody(), "Hello, World!");
+}
+
+TEST(HttpRequestTest, MaterializeCopiesViews) {
+    std::string uri = "/devices/7";
+    std::string headers = "Host: localhost\r\nX-Device-Id: lamp1";
+    std::string body = "payload";
+    HttpRequest request;
+    request.setUri(uri);
+    request.setHeaders(headers);
+    request.setArg("id", std::string_view(uri).substr(9));
+    request.setBody(body);
+    EXPECT_EQ(request.getUri().data(), uri.data());
+
+    HttpRequest copy = request;
+    copy.materialize();
+    uri.assign(uri.size(), '#');
+    headers.assign(headers.size(), '#');
+    body.assign(body.size(), '#');
+    EXPECT_EQ(copy.getUri(), "/devices/7");
+    EXPECT_EQ(copy.getArg<int>("id"), 7);
+    EXPECT_EQ(copy.getHeader("x-device-id"), "lamp1");
+    EXPECT_EQ(copy.getHeaders(), "Host: localhost\r\nX-Device-Id: lamp1");
+    EXPECT_EQ(copy.getBody(), "payload");
+    EXPECT_EQ(request.getUri(), "##########");
+}
+
+TEST(HttpRequestTest, AdoptedBodyOutlivesSource) {
+    HttpRequest request;
+    {
+        std::string body(100, 'x');
+        request.adoptBody(std::move(body));
+    }
+    HttpRequest copy = request;
+    request = HttpRequest();
+    copy.materialize();
+    EXPECT_EQ(copy.getBody(), std::string(100, 'x'));
+}
+
+TEST(HttpRequestTest, QueryParams) {
+    std::string query = "rate=10&unit=c&mode=fast&rate=20&flag&empty=";
+    HttpRequest request;
+    request.setQuery(query);
+    EXPECT_EQ(request.getQueryParam("unit"), "c");
+    EXPECT_EQ(request.getQueryParam<int>("rate"), 10);
+    EXPECT_FALSE(request.getQueryParam<int>("mode").has_value());
+    EXPECT_TRUE(request.hasQueryParam("flag"));
+    EXPECT_TRUE(request.hasQueryParam("empty"));
+    EXPECT_FALSE(request.hasQueryParam("missing"));
+    EXPECT_EQ(request.getQueryParams().size(), 6);
+    // Nothing escaped, so values view the query itself
+    EXPECT_EQ(request.getQueryParam("unit").data(), query.data() + 13);
+}
+
+TEST(HttpRequestTest, QueryParamsArePercentDecoded) {
+    HttpRequest request;
+    request.setQuery("name=living+room%2Flamp&raw=plain&bad=%zz%4&s%20p=1");
+    EXPECT_EQ(request.getQueryParam("name"), "living room/lamp");
+    EXPECT_EQ(request.getQueryParam("raw"), "plain");
+    EXPECT_EQ(request.getQueryParam("bad"), "%zz%4");
+    EXPECT_EQ(request.getQueryParam("s p"), "1");
+
+    HttpRequest copy = request;
+    request = HttpRequest();
+    EXPECT_EQ(copy.getQueryParam("name"), "living room/lamp");
+    copy.materialize();
+    EXPECT_EQ(copy.getQuery(), "name=living+room%2Flamp&raw=plain&bad=%zz%4&s%20p=1");
+    EXPECT_EQ(copy.getQueryParam("name"), "living room/lamp");
 }
\ No newline at end of file
@@ -37,6 +37,21 @@ TEST(HttpResourceTest, DisallowAll) {
     EXPECT_FALSE(resource.isAllowed(ioteye::HttpMethod::HTTP_GET));
 }
 
+TEST(HttpResourceTest, AllowedMethodsString) {
+    auto handler = std::make_shared<TestHandler>();
+    ioteye::HttpResource resource(handler, "/test");
+
+    EXPECT_EQ(resource.getAllowedMethodsAsString(), "GET, POST, PUT, DELETE, HEAD, OPTIONS, PATCH");
+    resource.setAllowing(ioteye::HttpMethod::HTTP_POST, false);
+    resource.setAllowing(ioteye::HttpMethod::HTTP_PATCH, false);
+    EXPECT_EQ(resource.getAllowedMethodsAsString(), "GET, PUT, DELETE, HEAD, OPTIONS");
+    resource.disallowAll();
+    EXPECT_EQ(resource.getAllowedMethodsAsString(), "");
+    resource.setAllowing(ioteye::HttpMethod::HTTP_DELETE, true);
+    EXPECT_EQ(resource.getAllowedMethodsAsString(), "DELETE");
+    EXPECT_FALSE(resource.isAllowed(ioteye::HttpMethod::UNKNOWN));
+}
+
 TEST(HttpResourceTest, ValidURI) {
     auto handler = std::make_shared<TestHandler>();
     ioteye::HttpResource resource(handler, "/user/{id}/profile");
@@ -46,6 +61,18 @@ TEST(HttpResourceTest, ValidURI) {
     EXPECT_EQ(resource.getParamNames()[0], "id");
 }
 
+TEST(HttpResourceTest, TypedParams) {
+    auto handler = std::make_shared<TestHandler>();
+    ioteye::HttpResource resource(handler, "/device/{id:int}/{ts:u64}/{name:alnum}/{raw}");
+
+    ASSERT_TRUE(resource.getIsValid());
+    EXPECT_EQ(resource.getParamNames(), (std::vector<std::string>{"id", "ts", "name", "raw"}));
+    EXPECT_EQ(resource.getParamTypes(),
+              (std::vector<ioteye::ParamType>{ioteye::ParamType::INT, ioteye::ParamType::U64,
+                                              ioteye::ParamType::ALNUM, ioteye::ParamType::STRING}));
+    EXPECT_FALSE(ioteye::HttpResource(handler, "/device/{id:float}").getIsValid());
+}
+
 TEST(HttpResourceTest, InvalidURI) {
     auto handler = std::make_shared<TestHandler>();
     ioteye::HttpResource resource(handler, "/user/{id");
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
 #include <ioteyeserver.hpp>
 
 TEST(HttpResponseTest, ConstructsAndFormatsCorrectly) {
@@ -51,3 +53,185 @@ TEST(HttpResponseTest, SettersWorkCorrectly) {
         ASSERT_EQ(response.getBody(), "test append");
     }
 }
+
+TEST(HttpResponseTest, BuffersMatchSerializedResponse) {
+    ioteye::HttpResponse response(200, "payload");
+    std::string head;
+    auto buffers = response.toBuffers(head);
+    std::string gathered;
+    for (const auto& buffer : buffers)
+        gathered.append(static_cast<const char*>(buffer.data()), buffer.size());
+    ASSERT_EQ(gathered, response.toString());
+    // Body is referenced, not serialized into the head
+    ASSERT_EQ(buffers[1].size(), 7u);
+    // Another write of the same response leaves the head of the first one alone
+    std::string otherHead;
+    auto other = response.toBuffers(otherHead);
+    EXPECT_NE(other[0].data(), buffers[0].data());
+    EXPECT_EQ(std::string(static_cast<const char*>(buffers[0].data()), buffers[0].size()), otherHead);
+    // Connection header of the write replaces the one of the response
+    response.setHeader("Connection", "close");
+    response.toBuffers(head, "keep-alive");
+    EXPECT_NE(head.find("Connection: keep-alive\r\n"), std::string::npos);
+    EXPECT_EQ(head.find("Connection: close"), std::string::npos);
+}
+
+TEST(HttpResponseTest, HeadOnlyResponseKeepsContentLength) {
+    ioteye::HttpResponse response(200, "payload");
+    response.setHeadOnly(true);
+    std::string head;
+    auto buffers = response.toBuffers(head);
+    EXPECT_EQ(buffers[1].size(), 0u);
+    EXPECT_NE(response.toString().find("Content-Length: 7\r\n"), std::string::npos);
+    EXPECT_EQ(response.toString().find("payload"), std::string::npos);
+}
+
+
+TEST(HttpResponseTest, HeadStartsWithStatusLineAndDate) {
+    ioteye::HttpResponse response(404, "Not Found");
+    std::string head = response.toString();
+    EXPECT_EQ(head.rfind("HTTP/1.1 404 Not Found\r\nDate: ", 0), 0u);
+    EXPECT_NE(head.find(" GMT\r\n"), std::string::npos);
+
+    // Own Date replaces the generated one, names are case-insensitive
+    response.setHeader("Date", "Sun, 06 Nov 1994 08:49:37 GMT");
+    response.setHeader("content-type", "application/json");
+    head = response.toString();
+    EXPECT_EQ(head.find("Date: ", head.find("Date: ") + 1), std::string::npos);
+    EXPECT_NE(head.find("Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"), std::string::npos);
+    EXPECT_EQ(head.find("text/plain"), std::string::npos);
+    EXPECT_EQ(response.getHeader("Content-Type"), "application/json");
+
+    // Codes without a known reason phrase still get a status line
+    EXPECT_EQ(ioteye::HttpResponse(299).toString().rfind("HTTP/1.1 299 Unknown Status\r\n", 0), 0u);
+}
+
+TEST(HttpResponseTest, StatusLinesArePrecomputed) {
+    static_assert(ioteye::util::getStatusLine(200) == "HTTP/1.1 200 OK\r\n");
+    EXPECT_EQ(ioteye::util::getStatusLine(431), "HTTP/1.1 431 Request Header Fields Too Large\r\n");
+    EXPECT_TRUE(ioteye::util::getStatusLine(299).empty());
+    EXPECT_TRUE(ioteye::util::getStatusLine(42).empty());
+    EXPECT_EQ(ioteye::util::getStatusMessage(404), "Not Found");
+    EXPECT_EQ(ioteye::util::getStatusMessage(299), "Unknown Status");
+}
+
+TEST(HttpResponseTest, CannedResponseIsSharedAndCopiedForChanges) {
+    ioteye::CannedResponse canned(ioteye::HttpResponse(200, "healthy"));
+    auto first = canned.get();
+    auto second = canned.get();
+    EXPECT_TRUE(first->isCanned());
+    // Same bytes within the same second, unless the second has just changed
+    if (first != second)
+        first = canned.get();
+    EXPECT_EQ(canned.get(), first);
+    // Canned bytes are shared by every write, the storage of the write stays unused
+    std::string head;
+    std::string otherHead;
+    auto buffers = first->toBuffers(head);
+    EXPECT_EQ(buffers[0].data(), first->toBuffers(otherHead)[0].data());
+    EXPECT_TRUE(head.empty());
+    // Connection header of the write goes into its own head, the canned bytes stay as they are
+    buffers = first->toBuffers(head, "close");
+    EXPECT_EQ(buffers[0].data(), head.data());
+    EXPECT_NE(head.find("Connection: close\r\n"), std::string::npos);
+    auto cannedHead = first->toBuffers(otherHead)[0];
+    EXPECT_EQ(std::string(static_cast<const char*>(cannedHead.data()), cannedHead.size()).find("Connection"),
+              std::string::npos);
+    EXPECT_EQ(std::string(static_cast<const char*>(buffers[1].data()), buffers[1].size()), "healthy");
+
+    auto copy = ioteye::makeMutable(first);
+    ASSERT_NE(copy, first);
+    EXPECT_FALSE(copy->isCanned());
+    copy->setHeadOnly(true);
+    copy->setHeader("Connection", "close");
+    EXPECT_NE(copy->toString().find("Connection: close"), std::string::npos);
+    EXPECT_EQ(first->toString().find("Connection: close"), std::string::npos);
+    EXPECT_NE(first->toString().find("healthy"), std::string::npos);
+
+    // A handler may keep its response, changes go to a copy as well
+    auto plain = std::make_shared<ioteye::HttpResponse>(200, "firmware");
+    auto plainCopy = ioteye::makeMutable(plain);
+    ASSERT_NE(plainCopy, plain);
+    plainCopy->setHeadOnly(true);
+    EXPECT_FALSE(plain->isHeadOnly());
+}
+
+TEST(HttpResponseTest, ErrorResponsesAreCanned) {
+    auto notFound = ioteye::createNotFoundResponse();
+    EXPECT_TRUE(notFound->isCanned());
+    EXPECT_EQ(notFound->getStatusCode(), 404);
+    EXPECT_EQ(notFound->getBody(), "Not Found");
+    auto tooLarge = ioteye::createErrorResponse(431);
+    EXPECT_TRUE(tooLarge->isCanned());
+    EXPECT_EQ(tooLarge->toString().rfind("HTTP/1.1 431 Request Header Fields Too Large\r\n", 0), 0u);
+    EXPECT_FALSE(ioteye::createErrorResponse(499)->isCanned());
+}
+TEST(HttpResponseTest, SharedBodyIsNotCopied) {
+    auto content = std::make_shared<std::string>("{\"fw\":\"1.2.0\"}");
+    ioteye::HttpResponse response(200);
+    response.setSharedBody(*content, content);
+    EXPECT_EQ(response.getBodyView().data(), content->data());
+    EXPECT_NE(response.toString().find("Content-Length: 14\r\n\r\n{\"fw\":\"1.2.0\"}"), std::string::npos);
+    std::string head;
+    auto buffers = response.toBuffers(head);
+    EXPECT_EQ(buffers[1].data(), content->data());
+
+    ioteye::HttpResponse copy(response);
+    content.reset();
+    EXPECT_EQ(copy.getBody(), "{\"fw\":\"1.2.0\"}");
+    copy.addBody("\n");
+    EXPECT_EQ(copy.getBody(), "{\"fw\":\"1.2.0\"}\n");
+    copy.setBody("replaced");
+    EXPECT_EQ(copy.getBodyView(), "replaced");
+}
+
+TEST(HttpResponseTest, GeneratedBodyIsChunked) {
+    auto response = std::make_shared<ioteye::HttpResponse>(200);
+    int calls = 0;
+    response->setBodyGenerator([&calls](std::string& chunk) {
+        chunk += "reading " + std::to_string(calls) + "\n";
+        return ++calls < 3;
+    });
+    std::string head = response->toString();
+    EXPECT_NE(head.find("Transfer-Encoding: chunked\r\n\r\n"), std::string::npos);
+    EXPECT_EQ(head.find("Content-Length"), std::string::npos);
+    EXPECT_EQ(calls, 0);
+
+    auto loaded = ioteye::loadBody(response);
+    EXPECT_EQ(calls, 3);
+    EXPECT_FALSE(loaded->getBodyGenerator());
+    EXPECT_EQ(loaded->getBody(), "reading 0\nreading 1\nreading 2\n");
+    EXPECT_NE(loaded->toString().find("Content-Length: 30\r\n"), std::string::npos);
+
+    auto failing = std::make_shared<ioteye::HttpResponse>(200);
+    failing->setBodyGenerator([](std::string&) -> bool { throw std::runtime_error("storage unavailable"); });
+    EXPECT_EQ(ioteye::loadBody(failing)->getStatusCode(), 500);
+
+    // Nothing waits for a notifier while the body is loaded
+    auto waiting = std::make_shared<ioteye::HttpResponse>(200);
+    waiting->setBodyGenerator([](std::string&) { return true; }, std::make_shared<ioteye::BodyNotifier>());
+    EXPECT_EQ(ioteye::loadBody(waiting)->getStatusCode(), 500);
+}
+
+TEST(HttpResponseTest, FileBodyIsReadOnDemand) {
+    auto path = std::filesystem::temp_directory_path() / "ioteye_response_file_body.bin";
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "firmware image";
+    ioteye::HttpResponse response(200);
+    response.setFileBody(ioteye::FileBody::open(path.string()));
+    std::filesystem::remove(path);
+    ASSERT_NE(response.getFileBody(), nullptr);
+    EXPECT_EQ(response.getHeader("Accept-Ranges"), "bytes");
+    EXPECT_EQ(response.getBodySize(), 14u);
+    EXPECT_TRUE(response.getBodyView().empty());
+    EXPECT_NE(response.toString().find("Content-Length: 14\r\n\r\nfirmware image"), std::string::npos);
+
+    response.setBodyRange(9, 5);
+    EXPECT_EQ(response.getFileOffset(), 9u);
+    EXPECT_EQ(response.getBody(), "image");
+    EXPECT_NE(response.toString().find("Content-Length: 5\r\n"), std::string::npos);
+    response.setBody("replaced");
+    EXPECT_EQ(response.getFileBody(), nullptr);
+    EXPECT_EQ(response.getBodyView(), "replaced");
+    response.setBodyRange(2, 100);
+    EXPECT_EQ(response.getBodyView(), "placed");
+}
@@ -0,0 +1,182 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "ioteyeserver/httpserver/response_cache.hpp"
+#include "test_helpers.hpp"
+
+namespace ioteye {
+namespace {
+ResponseCache::Config makeConfig(std::chrono::milliseconds ttl) {
+    ResponseCache::Config config;
+    config.ttl = ttl;
+    return config;
+}
+}  // namespace
+
+TEST(ResponseCacheTest, CachesOkResponses) {
+    ResponseCache cache(makeConfig(std::chrono::seconds(60)));
+    int renders = 0;
+    auto render = [&]() {
+        ++renders;
+        return std::make_shared<HttpResponse>(200, "config v1");
+    };
+    auto first = cache.respond(makeRequest("/config"), render);
+    auto second = cache.respond(makeRequest("/config"), render);
+    EXPECT_EQ(renders, 1);
+    EXPECT_TRUE(second->isCanned());
+    EXPECT_EQ(second->getBody(), "config v1");
+    EXPECT_EQ(second->getHeader("ETag"), ResponseCache::makeETag("config v1"));
+    EXPECT_EQ(cache.getStats().hits, 1u);
+    EXPECT_EQ(cache.getStats().misses, 1u);
+}
+
+TEST(ResponseCacheTest, SkipsErrorResponses) {
+    ResponseCache cache(makeConfig(std::chrono::seconds(60)));
+    int renders = 0;
+    auto render = [&]() {
+        ++renders;
+        return std::make_shared<HttpResponse>(500, "oops");
+    };
+    cache.respond(makeRequest("/config"), render);
+    auto response = cache.respond(makeRequest("/config"), render);
+    EXPECT_EQ(renders, 2);
+    EXPECT_EQ(response->getStatusCode(), 500);
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(ResponseCacheTest, KeepsHandlerETag) {
+    ResponseCache cache(makeConfig(std::chrono::seconds(60)));
+    auto response = cache.respond(makeRequest("/firmware"), []() {
+        auto response = std::make_shared<HttpResponse>(200, "image");
+        response->setHeader("ETag", "\"v42\"");
+        return response;
+    });
+    EXPECT_EQ(response->getHeader("ETag"), "\"v42\"");
+}
+
+TEST(ResponseCacheTest, AnswersIfNoneMatch) {
+    ResponseCache cache(makeConfig(std::chrono::seconds(60)));
+    int renders = 0;
+    auto render = [&]() {
+        ++renders;
+        auto response = std::make_shared<HttpResponse>(200, "{\"v\":1}");
+        response->setContentType("application/json");
+        return response;
+    };
+    std::string etag = cache.respond(makeRequest("/config"), render)->getHeader("ETag");
+    auto response = cache.respond(makeRequest("/config", "If-None-Match: \"other\", " + etag), render);
+    EXPECT_EQ(renders, 1);
+    EXPECT_EQ(response->getStatusCode(), 304);
+    EXPECT_EQ(response->getBody(), "");
+    EXPECT_EQ(response->getHeader("ETag"), etag);
+    EXPECT_EQ(response->getHeader("Content-Type"), "application/json");
+    EXPECT_EQ(response->toString().find("Content-Length"), std::string::npos);
+    EXPECT_EQ(cache.getStats().notModified, 1u);
+
+    response = cache.respond(makeRequest("/config", "If-None-Match: \"other\""), render);
+    EXPECT_EQ(response->getStatusCode(), 200);
+}
+
+TEST(ResponseCacheTest, MatchesIfNoneMatch) {
+    EXPECT_TRUE(ResponseCache::matchesIfNoneMatch("\"a\"", "\"a\""));
+    EXPECT_TRUE(ResponseCache::matchesIfNoneMatch("*", "\"a\""));
+    EXPECT_TRUE(ResponseCache::matchesIfNoneMatch("W/\"a\"", "\"a\""));
+    EXPECT_TRUE(ResponseCache::matchesIfNoneMatch("\"b\" , \"a\"", "\"a\""));
+    EXPECT_FALSE(ResponseCache::matchesIfNoneMatch("\"b\"", "\"a\""));
+    EXPECT_FALSE(ResponseCache::matchesIfNoneMatch("", "\"a\""));
+    EXPECT_FALSE(ResponseCache::matchesIfNoneMatch("\"ab\"", "\"a\""));
+}
+
+TEST(ResponseCacheTest, ExpiresAfterTtl) {
+    ResponseCache cache(makeConfig(std::chrono::milliseconds(20)));
+    int renders = 0;
+    auto render = [&]() {
+        ++renders;
+        return std::make_shared<HttpResponse>(200, "state " + std::to_string(renders));
+    };
+    cache.respond(makeRequest("/state"), render);
+    cache.respond(makeRequest("/state"), render);
+    EXPECT_EQ(renders, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_EQ(cache.respond(makeRequest("/state"), render)->getBody(), "state 2");
+}
+
+TEST(ResponseCacheTest, KeysOnSelectedArgsAndHeaders) {
+    ResponseCache::Config config;
+    config.ttl = std::chrono::seconds(60);
+    config.keyArgs = {"device"};
+    config.keyHeaders = {"Accept"};
+    ResponseCache cache(config);
+    int renders = 0;
+    auto render = [&]() {
+        ++renders;
+        return std::make_shared<HttpResponse>(200, std::to_string(renders));
+    };
+    auto request = makeRequest("/config", "Accept: text/plain");
+    request.setQuery("device=1&nonce=5");
+    cache.respond(request, render);
+    request.setQuery("device=1&nonce=6");
+    EXPECT_EQ(cache.respond(request, render)->getBody(), "1");
+    request.setQuery("device=2");
+    EXPECT_EQ(cache.respond(request, render)->getBody(), "2");
+    request.setHeaders("Accept: application/json");
+    EXPECT_EQ(cache.respond(request, render)->getBody(), "3");
+    EXPECT_EQ(cache.size(), 3u);
+}
+
+TEST(ResponseCacheTest, InvalidatesByPath) {
+    ResponseCache::Config config;
+    config.keyArgs = {"device"};
+    ResponseCache cache(config);
+    auto render = []() { return std::make_shared<HttpResponse>(200, "x"); };
+    auto request = makeRequest("/config");
+    request.setQuery("device=1");
+    cache.respond(request, render);
+    cache.respond(makeRequest("/configs"), render);
+    cache.respond(makeRequest("/other"), render);
+    cache.invalidate("/config");
+    EXPECT_EQ(cache.size(), 2u);
+    cache.invalidate();
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(ResponseCacheTest, BoundsEntries) {
+    ResponseCache::Config config;
+    config.ttl = std::chrono::seconds(60);
+    config.maxEntries = 2;
+    ResponseCache cache(config);
+    auto render = []() { return std::make_shared<HttpResponse>(200, "x"); };
+    cache.respond(makeRequest("/a"), render);
+    cache.respond(makeRequest("/b"), render);
+    cache.respond(makeRequest("/c"), render);
+    EXPECT_EQ(cache.size(), 2u);
+}
+}  // namespace ioteye
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <ioteyeserver.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ioteye;
+
+namespace {
+std::shared_ptr<HttpResource> makeResource(const std::string& uri) {
+    return std::make_shared<HttpResource>(std::make_shared<HttpResourceHandler>(), uri);
+}
+
+std::string argOf(const Router::Match& match, std::string_view name) {
+    for (const auto& [argName, value] : match.args)
+        if (argName == name)
+            return std::string(value);
+    return "";
+}
+}  // namespace
+
+TEST(RouterTest, MatchesStaticRoutes) {
+    Router router;
+    auto root = makeResource("/");
+    auto devices = makeResource("/api/v1/devices");
+    auto status = makeResource("/api/v1/status");
+    router.addResource(root);
+    router.addResource(devices);
+    router.addResource(status);
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/", match));
+    EXPECT_EQ(match.resource, root);
+    ASSERT_TRUE(router.match("/api/v1/devices", match));
+    EXPECT_EQ(match.resource, devices);
+    ASSERT_TRUE(router.match("/api/v1/status", match));
+    EXPECT_EQ(match.resource, status);
+    EXPECT_FALSE(router.match("/api/v1", match));
+    EXPECT_FALSE(router.match("/api/v1/devices/1", match));
+    EXPECT_FALSE(router.match("/api/v1/dev", match));
+}
+
+TEST(RouterTest, CapturesParameters) {
+    Router router;
+    auto sensor = makeResource("/devices/{id}/sensors/{sensor}");
+    router.addResource(sensor);
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/devices/42/sensors/temp", match));
+    EXPECT_EQ(match.resource, sensor);
+    ASSERT_EQ(match.args.size(), 2u);
+    EXPECT_EQ(argOf(match, "id"), "42");
+    EXPECT_EQ(argOf(match, "sensor"), "temp");
+    // Parameter has to capture a non-empty segment
+    EXPECT_FALSE(router.match("/devices//sensors/temp", match));
+    EXPECT_FALSE(router.match("/devices/42/sensors", match));
+}
+
+TEST(RouterTest, StaticRoutesTakePrecedence) {
+    Router router;
+    auto byId = makeResource("/devices/{id}");
+    auto all = makeResource("/devices/all");
+    auto reboot = makeResource("/devices/{id}/reboot");
+    router.addResource(byId);
+    router.addResource(all);
+    router.addResource(reboot);
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/devices/all", match));
+    EXPECT_EQ(match.resource, all);
+    EXPECT_TRUE(match.args.empty());
+    ASSERT_TRUE(router.match("/devices/7", match));
+    EXPECT_EQ(match.resource, byId);
+    EXPECT_EQ(argOf(match, "id"), "7");
+    // Static branch is a dead end, so the parameter is tried
+    ASSERT_TRUE(router.match("/devices/all/reboot", match));
+    EXPECT_EQ(match.resource, reboot);
+    EXPECT_EQ(argOf(match, "id"), "all");
+}
+
+TEST(RouterTest, MatchesTypedParameters) {
+    Router router;
+    auto byId = makeResource("/devices/{id:int}");
+    auto byName = makeResource("/devices/{name:alnum}");
+    auto reading = makeResource("/readings/{ts:u64}");
+    router.addResource(byName);
+    router.addResource(byId);
+    router.addResource(reading);
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/devices/-15", match));
+    EXPECT_EQ(match.resource, byId);
+    EXPECT_EQ(argOf(match, "id"), "-15");
+    ASSERT_TRUE(router.match("/devices/lamp2", match));
+    EXPECT_EQ(match.resource, byName);
+    EXPECT_EQ(argOf(match, "name"), "lamp2");
+    EXPECT_FALSE(router.match("/devices/lamp-2", match));
+    EXPECT_TRUE(match.args.empty());
+
+    ASSERT_TRUE(router.match("/readings/18446744073709551615", match));
+    EXPECT_EQ(match.resource, reading);
+    EXPECT_FALSE(router.match("/readings/18446744073709551616", match));
+    EXPECT_FALSE(router.match("/readings/-1", match));
+}
+
+TEST(RouterTest, RegexRoutesCheckParameterTypes) {
+    Router router;
+    auto file = makeResource("/files/report-{id:int}");
+    router.addResource(file);
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/files/report-7", match));
+    EXPECT_EQ(argOf(match, "id"), "7");
+    EXPECT_FALSE(router.match("/files/report-99999999999999999999", match));
+    EXPECT_FALSE(router.match("/files/report-x", match));
+}
+
+TEST(RouterTest, SplitsSharedStaticPrefixes) {
+    Router router;
+    auto first = makeResource("/a/b/c");
+    auto second = makeResource("/a/b/d");
+    auto prefix = makeResource("/a");
+    router.addResource(first);
+    router.addResource(second);
+    router.addResource(prefix);
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/a/b/c", match));
+    EXPECT_EQ(match.resource, first);
+    ASSERT_TRUE(router.match("/a/b/d", match));
+    EXPECT_EQ(match.resource, second);
+    ASSERT_TRUE(router.match("/a", match));
+    EXPECT_EQ(match.resource, prefix);
+    EXPECT_FALSE(router.match("/a/b", match));
+}
+
+TEST(RouterTest, ResolvesStaticRoutesFromBuiltTable) {
+    Router router;
+    std::vector<std::shared_ptr<HttpResource>> resources;
+    for (int i = 0; i < 500; ++i) {
+        resources.push_back(makeResource("/api/device" + std::to_string(i) + "/status"));
+        router.addResource(resources.back());
+    }
+    auto byId = makeResource("/api/{id}/status");
+    router.addResource(byId);
+    auto replaced = makeResource("/api/device7/status");
+    router.addResource(replaced);
+    router.build();
+
+    Router::Match match;
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_TRUE(router.match("/api/device" + std::to_string(i) + "/status", match));
+        EXPECT_EQ(match.resource, i == 7 ? replaced : resources[i]);
+        EXPECT_TRUE(match.args.empty());
+    }
+    ASSERT_TRUE(router.match("/api/device500/status", match));
+    EXPECT_EQ(match.resource, byId);
+    EXPECT_EQ(argOf(match, "id"), "device500");
+    EXPECT_FALSE(router.match("/api/device1", match));
+}
+
+TEST(RouterTest, FallsBackToRegexForInnerParameters) {
+    Router router;
+    auto file = makeResource("/files/report-{id}");
+    router.addResource(file);
+    router.addResource(makeResource("/broken/{id"));
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/files/report-12", match));
+    EXPECT_EQ(match.resource, file);
+    EXPECT_EQ(argOf(match, "id"), "12");
+    EXPECT_FALSE(router.match("/broken/1", match));
+}
+
+TEST(RouterTest, TriesRegexRoutesInOrderOfPatterns) {
+    auto report = makeResource("/files/report-{id}");
+    auto any = makeResource("/files/{prefix}-{id}");
+    for (bool isReportFirst : {true, false}) {
+        Router router;
+        router.addResource(isReportFirst ? report : any);
+        router.addResource(isReportFirst ? any : report);
+        router.build();
+
+        Router::Match match;
+        ASSERT_TRUE(router.match("/files/report-12", match));
+        EXPECT_EQ(match.resource, report);
+        ASSERT_TRUE(router.match("/files/summary-12", match));
+        EXPECT_EQ(match.resource, any);
+    }
+}
+
+TEST(RouterTest, PathParameterTakesRestOfUri) {
+    Router router;
+    auto assets = makeResource("/ui/{file:path}");
+    auto config = makeResource("/ui/config");
+    auto firmware = makeResource("/fw/{name:path}/meta");
+    router.addResource(assets);
+    router.addResource(config);
+    router.addResource(firmware);
+    router.build();
+
+    Router::Match match;
+    ASSERT_TRUE(router.match("/ui/css/main.css", match));
+    EXPECT_EQ(match.resource, assets);
+    EXPECT_EQ(argOf(match, "file"), "css/main.css");
+    ASSERT_TRUE(router.match("/ui/index.html", match));
+    EXPECT_EQ(argOf(match, "file"), "index.html");
+    ASSERT_TRUE(router.match("/ui/config", match));
+    EXPECT_EQ(match.resource, config);
+    ASSERT_TRUE(router.match("/ui/config/extra", match));
+    EXPECT_EQ(match.resource, assets);
+    EXPECT_FALSE(router.match("/ui", match));
+    EXPECT_FALSE(router.match("/ui/", match));
+    // Not the last segment, matched by regex
+    ASSERT_TRUE(router.match("/fw/a/b/meta", match));
+    EXPECT_EQ(match.resource, firmware);
+    EXPECT_EQ(argOf(match, "name"), "a/b");
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <ioteyeserver.hpp>
+
+using namespace ioteye;
+
+TEST(SmallVectorTest, StaysInlineUpToCapacity) {
+    util::SmallVector<std::string, 2> vector;
+    vector.push_back("first");
+    vector.emplace_back(3, 'x');
+    EXPECT_TRUE(vector.isInline());
+    EXPECT_EQ(vector.size(), 2u);
+
+    // Element of the vector itself is copied before the storage moves to the heap
+    vector.push_back(vector[0]);
+    EXPECT_FALSE(vector.isInline());
+    ASSERT_EQ(vector.size(), 3u);
+    EXPECT_EQ(vector[0], "first");
+    EXPECT_EQ(vector[1], "xxx");
+    EXPECT_EQ(vector[2], "first");
+
+    vector.erase(vector.begin());
+    ASSERT_EQ(vector.size(), 2u);
+    EXPECT_EQ(vector[0], "xxx");
+    EXPECT_EQ(vector.back(), "first");
+}
+
+TEST(SmallVectorTest, CopiesAndMoves) {
+    util::SmallVector<std::string, 2> small = {"a", "b"};
+    util::SmallVector<std::string, 2> large = {"a", "b", "c"};
+
+    util::SmallVector<std::string, 2> copy = large;
+    EXPECT_EQ(copy.size(), 3u);
+    EXPECT_EQ(copy[2], "c");
+
+    util::SmallVector<std::string, 2> moved = std::move(small);
+    EXPECT_TRUE(moved.isInline());
+    EXPECT_EQ(moved[1], "b");
+    EXPECT_TRUE(small.empty());
+
+    const std::string* data = large.data();
+    moved = std::move(large);
+    // Heap storage changes hands without copying the elements
+    EXPECT_EQ(moved.data(), data);
+    EXPECT_EQ(moved.size(), 3u);
+    EXPECT_TRUE(large.empty());
+    EXPECT_TRUE(large.isInline());
+
+    large = moved;
+    EXPECT_EQ(large.size(), 3u);
+    EXPECT_EQ(large[0], "a");
+}
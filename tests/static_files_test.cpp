@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "ioteyeserver/httpserver/static_files.hpp"
+#include "test_helpers.hpp"
+
+namespace ioteye {
+namespace {
+void writeFile(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+}
+
+// Request as routed to the handler, with the {path} argument of the matched route
+HttpRequest makeFileRequest(std::string_view path, std::string_view headers = "") {
+    HttpRequest request = makeRequest("/static/" + std::string(path), headers);
+    request.setArg("path", path);
+    return request;
+}
+
+class StaticFilesTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() /
+                    ("ioteye_static_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(directory);
+        writeFile(directory / "index.html", "<h1>devices</h1>");
+        writeFile(directory / "schemas" / "config.json", "{\"type\":\"object\"}");
+        writeFile(directory / "docs" / "index.html", "docs");
+    }
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+};
+}  // namespace
+
+TEST(StaticFilesPathTest, ResolvesPaths) {
+    std::string path;
+    ASSERT_TRUE(StaticFileHandler::resolvePath("css/main.css", "index.html", path));
+    EXPECT_EQ(path, "css/main.css");
+    ASSERT_TRUE(StaticFileHandler::resolvePath("", "index.html", path));
+    EXPECT_EQ(path, "index.html");
+    ASSERT_TRUE(StaticFileHandler::resolvePath("docs/", "index.html", path));
+    EXPECT_EQ(path, "docs/index.html");
+    ASSERT_TRUE(StaticFileHandler::resolvePath("a//b%20c.txt", "index.html", path));
+    EXPECT_EQ(path, "a/b c.txt");
+    EXPECT_FALSE(StaticFileHandler::resolvePath("../etc/passwd", "index.html", path));
+    EXPECT_FALSE(StaticFileHandler::resolvePath("css/../../secret", "index.html", path));
+    EXPECT_FALSE(StaticFileHandler::resolvePath("%2e%2e/secret", "index.html", path));
+    EXPECT_FALSE(StaticFileHandler::resolvePath("a%5c..%5csecret", "index.html", path));
+    EXPECT_FALSE(StaticFileHandler::resolvePath("a%00.html", "index.html", path));
+}
+
+TEST(StaticFilesPathTest, PicksMimeTypes) {
+    EXPECT_EQ(StaticFileHandler::getMimeType("index.html"), "text/html; charset=utf-8");
+    EXPECT_EQ(StaticFileHandler::getMimeType("app.JS"), "application/javascript");
+    EXPECT_EQ(StaticFileHandler::getMimeType("schemas/config.json"), "application/json");
+    EXPECT_EQ(StaticFileHandler::getMimeType("firmware.bin"), "application/octet-stream");
+    EXPECT_EQ(StaticFileHandler::getMimeType("v1.2/README"), "application/octet-stream");
+}
+
+TEST_F(StaticFilesTest, ServesCachedFiles) {
+    StaticFileHandler handler(directory.string());
+    auto first = handler.renderGET(makeFileRequest("schemas/config.json"));
+    ASSERT_EQ(first->getStatusCode(), 200);
+    EXPECT_EQ(first->getBody(), "{\"type\":\"object\"}");
+    EXPECT_EQ(first->getHeader("Content-Type"), "application/json");
+    EXPECT_FALSE(first->getHeader("ETag").empty());
+    EXPECT_FALSE(first->getHeader("Last-Modified").empty());
+    EXPECT_NE(first->toString().find("Content-Length: 17\r\n"), std::string::npos);
+
+    auto second = handler.renderGET(makeFileRequest("schemas/config.json"));
+    EXPECT_TRUE(second->isCanned());
+    // Both share the cached bytes
+    EXPECT_EQ(first->getBodyView().data(), second->getBodyView().data());
+    StaticFileHandler::Stats stats = handler.getStats();
+    EXPECT_EQ(stats.loads, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.cachedFiles, 1u);
+    EXPECT_EQ(stats.cachedBytes, 17u);
+}
+
+TEST_F(StaticFilesTest, ServesIndexFiles) {
+    StaticFileHandler handler(directory.string());
+    EXPECT_EQ(handler.renderGET(makeFileRequest(""))->getBody(), "<h1>devices</h1>");
+    EXPECT_EQ(handler.renderGET(makeFileRequest("docs/"))->getBody(), "docs");
+    EXPECT_EQ(handler.renderGET(makeFileRequest("docs"))->getBody(), "docs");
+    EXPECT_EQ(handler.renderGET(makeFileRequest("missing.css"))->getStatusCode(), 404);
+    EXPECT_EQ(handler.renderGET(makeFileRequest("schemas"))->getStatusCode(), 404);
+    EXPECT_EQ(handler.renderGET(makeFileRequest("../index.html"))->getStatusCode(), 404);
+}
+
+TEST_F(StaticFilesTest, AnswersConditionalRequests) {
+    StaticFileHandler handler(directory.string());
+    auto response = handler.renderGET(makeFileRequest("index.html"));
+    std::string etag = response->getHeader("ETag");
+    std::string lastModified = response->getHeader("Last-Modified");
+
+    auto notModified = handler.renderGET(makeFileRequest("index.html", "If-None-Match: " + etag));
+    EXPECT_EQ(notModified->getStatusCode(), 304);
+    EXPECT_EQ(notModified->getBody(), "");
+    EXPECT_EQ(notModified->getHeader("ETag"), etag);
+    notModified = handler.renderGET(makeFileRequest("index.html", "If-Modified-Since: " + lastModified));
+    EXPECT_EQ(notModified->getStatusCode(), 304);
+    EXPECT_EQ(handler.renderGET(makeFileRequest("index.html", "If-None-Match: \"stale\""))->getStatusCode(), 200);
+    EXPECT_EQ(handler.getStats().notModified, 2u);
+}
+
+TEST_F(StaticFilesTest, ReloadsChangedFiles) {
+    StaticFileHandler::Config config;
+    config.checkInterval = std::chrono::milliseconds(0);
+    StaticFileHandler handler(directory.string(), config);
+    EXPECT_EQ(handler.renderGET(makeFileRequest("index.html"))->getBody(), "<h1>devices</h1>");
+    writeFile(directory / "index.html", "<h1>devices v2</h1>");
+    EXPECT_EQ(handler.renderGET(makeFileRequest("index.html"))->getBody(), "<h1>devices v2</h1>");
+    std::filesystem::remove(directory / "index.html");
+    EXPECT_EQ(handler.renderGET(makeFileRequest("index.html"))->getStatusCode(), 404);
+    EXPECT_EQ(handler.getStats().cachedFiles, 0u);
+}
+
+TEST_F(StaticFilesTest, StreamsLargeFiles) {
+    std::string image(64 * 1024, 'x');
+    writeFile(directory / "image.bin", image);
+    StaticFileHandler::Config config;
+    config.maxCachedFileSize = 1024;
+    StaticFileHandler handler(directory.string(), config);
+    auto response = handler.renderGET(makeFileRequest("image.bin"));
+    ASSERT_NE(response->getFileBody(), nullptr);
+    EXPECT_EQ(response->getBodySize(), image.size());
+    EXPECT_EQ(response->getBody(), image);
+    EXPECT_EQ(response->getHeader("Content-Type"), "application/octet-stream");
+    EXPECT_EQ(response->getHeader("Accept-Ranges"), "bytes");
+    EXPECT_EQ(handler.getStats().cachedFiles, 0u);
+    // Small files are cached as usual
+    handler.renderGET(makeFileRequest("index.html"));
+    EXPECT_EQ(handler.getStats().cachedFiles, 1u);
+}
+
+TEST_F(StaticFilesTest, LimitsCacheSize) {
+    StaticFileHandler::Config config;
+    config.maxCacheSize = 20;
+    StaticFileHandler handler(directory.string(), config);
+    handler.renderGET(makeFileRequest("index.html"));
+    EXPECT_EQ(handler.renderGET(makeFileRequest("schemas/config.json"))->getStatusCode(), 200);
+    EXPECT_EQ(handler.getStats().cachedFiles, 1u);
+    EXPECT_EQ(handler.getStats().cachedBytes, 16u);
+}
+}  // namespace ioteye
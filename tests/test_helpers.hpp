@@ -0,0 +1,43 @@
+/*
+MIT License
+
+Copyright (c) 2025 Shults Bogdan aka K1joL
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef IOTEYE_TEST_HELPERS_HPP
+#define IOTEYE_TEST_HELPERS_HPP
+
+#include <string_view>
+
+#include "ioteyeserver/httpserver/http_request.hpp"
+
+namespace ioteye {
+// GET request for uri, headers are raw "Name: value\r\n" lines as they arrive on the wire
+inline HttpRequest makeRequest(std::string_view uri, std::string_view headers = "") {
+    HttpRequest request;
+    request.setMethod(HttpMethod::HTTP_GET);
+    request.setUri(uri);
+    request.setHeaders(headers);
+    return request;
+}
+}  // namespace ioteye
+
+#endif  // IOTEYE_TEST_HELPERS_HPP
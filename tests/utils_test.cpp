@@ -26,6 +26,9 @@ TEST(UtilsTest, StringToHttpMethodConvertsCorrectly) {
         EXPECT_EQ(util::stringToHttpMethod("POST"), HttpMethod::HTTP_POST);
         EXPECT_EQ(util::stringToHttpMethod("PUT"), HttpMethod::HTTP_PUT);
         EXPECT_EQ(util::stringToHttpMethod("DELETE"), HttpMethod::HTTP_DELETE);
+        EXPECT_EQ(util::stringToHttpMethod("HEAD"), HttpMethod::HTTP_HEAD);
+        EXPECT_EQ(util::stringToHttpMethod("OPTIONS"), HttpMethod::HTTP_OPTIONS);
+        EXPECT_EQ(util::stringToHttpMethod("PATCH"), HttpMethod::HTTP_PATCH);
     }
 
     {
@@ -42,6 +45,9 @@ TEST(UtilsTest, HttpMethodToStringConvertsCorrectly) {
         EXPECT_EQ(util::httpMethodToString(HttpMethod::HTTP_POST), "POST");
         EXPECT_EQ(util::httpMethodToString(HttpMethod::HTTP_PUT), "PUT");
         EXPECT_EQ(util::httpMethodToString(HttpMethod::HTTP_DELETE), "DELETE");
+        EXPECT_EQ(util::httpMethodToString(HttpMethod::HTTP_HEAD), "HEAD");
+        EXPECT_EQ(util::httpMethodToString(HttpMethod::HTTP_OPTIONS), "OPTIONS");
+        EXPECT_EQ(util::httpMethodToString(HttpMethod::HTTP_PATCH), "PATCH");
     }
 
     {
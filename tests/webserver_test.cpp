@@ -27,16 +27,29 @@ SOFTWARE.
 #include <asio.hpp>
 #include <asio/ts/buffer.hpp>
 #include <asio/ts/internet.hpp>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <ioteyeserver.hpp>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <unordered_map>
 
 namespace ioteye {
 
+// Date changes every second, responses are compared without it
+std::string removeDateHeader(std::string response) {
+    size_t start = response.find("\r\nDate: ");
+    if (start != std::string::npos)
+        response.erase(start, response.find("\r\n", start + 2) - start);
+    return response;
+}
+
 // Mock HttpResponseHandler for testing purposes
 class MockResourceHandler : public HttpResourceHandler {
 public:
@@ -52,7 +65,7 @@ public:
         (void)req;
         auto response = std::make_shared<HttpResponse>();
         response->setStatusCode(201);
-        response->setBody("POST Response: " + req.getBody());
+        response->setBody("POST Response: " + std::string(req.getBody()));
         return response;
     }
 
@@ -60,7 +73,7 @@ public:
         (void)req;
         auto response = std::make_shared<HttpResponse>();
         response->setStatusCode(200);
-        response->setBody("PUT Response: " + req.getArg("id"));
+        response->setBody("PUT Response: " + std::string(req.getArg("id")));
         return response;
     }
 
@@ -74,13 +87,229 @@ public:
     }
 };
 
+// Handler which blocks the calling thread for a while
+class SlowResourceHandler : public HttpResourceHandler {
+public:
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override {
+        (void)req;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        return std::make_shared<HttpResponse>(200, "Slow Response");
+    }
+};
+
+// Handler which answers with an empty body
+class EmptyResourceHandler : public HttpResourceHandler {
+public:
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override {
+        (void)req;
+        return std::make_shared<HttpResponse>(200, "");
+    }
+};
+
+// Handler which answers every request with the same response object
+class SharedResponseHandler : public HttpResourceHandler {
+public:
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override {
+        (void)req;
+        return m_response;
+    }
+
+private:
+    std::shared_ptr<HttpResponse> m_response = std::make_shared<HttpResponse>(200, "firmware 1.2.0");
+};
+
+// Handler which counts how often it actually renders
+class CountingResourceHandler : public HttpResourceHandler {
+public:
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override {
+        (void)req;
+        return std::make_shared<HttpResponse>(200, "version " + std::to_string(++renders));
+    }
+    std::shared_ptr<HttpResponse> renderPUT(const HttpRequest& req) override {
+        (void)req;
+        return std::make_shared<HttpResponse>(204);
+    }
+
+    std::atomic<int> renders{0};
+};
+
+// Handler which streams an export too large to build up front
+class ExportResourceHandler : public HttpResourceHandler {
+public:
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override {
+        (void)req;
+        auto response = std::make_shared<HttpResponse>(200);
+        response->setContentType("text/csv");
+        response->setBodyGenerator([next = 0](std::string& chunk) mutable {
+            for (int end = next + 100; next < end; ++next)
+                chunk += std::to_string(next) + ",21.5\n";
+            return next < kReadings;
+        });
+        return response;
+    }
+
+    static std::string expectedBody() {
+        std::string body;
+        for (int i = 0; i < kReadings; ++i)
+            body += std::to_string(i) + ",21.5\n";
+        return body;
+    }
+
+    static constexpr int kReadings = 5000;
+};
+
+// Streams readings as a sensor produces them, the generator waits for each one
+class FeedResourceHandler : public HttpResourceHandler {
+public:
+    explicit FeedResourceHandler(int readings) : m_readings(readings) {
+    }
+    ~FeedResourceHandler() override {
+        if (m_sensor.joinable())
+            m_sensor.join();
+    }
+
+    std::shared_ptr<HttpResponse> renderGET(const HttpRequest& req) override {
+        (void)req;
+        auto notifier = std::make_shared<BodyNotifier>();
+        auto response = std::make_shared<HttpResponse>(200);
+        response->setBodyGenerator(
+            [this](std::string& chunk) {
+                ++calls;
+                std::lock_guard<std::mutex> lock(m_mutex);
+                chunk = std::move(m_ready);
+                m_ready.clear();
+                return !m_isDone || !chunk.empty();
+            },
+            notifier);
+        if (m_sensor.joinable())
+            m_sensor.join();
+        m_sensor = std::thread([this, notifier]() {
+            for (int i = 0; i < m_readings; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_ready += std::to_string(i) + ",21.5\n";
+                    m_isDone = i + 1 == m_readings;
+                }
+                notifier->resume();
+            }
+        });
+        return response;
+    }
+
+    std::atomic<int> calls{0};
+
+private:
+    int m_readings;
+    std::thread m_sensor;
+    std::mutex m_mutex;
+    std::string m_ready;
+    bool m_isDone = false;
+};
+
+// Counts the lines of an upload while it arrives, pausing after every other piece
+class LogConsumer : public BodyConsumer {
+public:
+    explicit LogConsumer(std::atomic<int>& aborts) : m_aborts(aborts) {
+    }
+    ~LogConsumer() override {
+        if (m_resumer.joinable())
+            m_resumer.join();
+    }
+
+    bool onData(std::string_view data) override {
+        if (m_isPaused)
+            m_readWhilePaused = true;
+        m_bytes += data.size();
+        m_lines += std::count(data.begin(), data.end(), '\n');
+        if (++m_pieces % 2)
+            return true;
+        m_isPaused = true;
+        if (m_resumer.joinable())
+            m_resumer.join();
+        m_resumer = std::thread([this]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            m_isPaused = false;
+            resume();
+        });
+        return false;
+    }
+    std::shared_ptr<HttpResponse> onEnd(const HttpRequest& req) override {
+        std::string body = std::string(req.getArg("device")) + ": " + std::to_string(m_lines) + " lines, " +
+                           std::to_string(m_bytes) + " bytes" + (m_readWhilePaused ? ", read while paused" : "");
+        return std::make_shared<HttpResponse>(201, body);
+    }
+    void onAbort() override {
+        ++m_aborts;
+    }
+
+private:
+    std::atomic<int>& m_aborts;
+    std::thread m_resumer;
+    std::atomic<bool> m_isPaused{false};
+    bool m_readWhilePaused = false;
+    size_t m_pieces = 0;
+    size_t m_bytes = 0;
+    size_t m_lines = 0;
+};
+
+class LogUploadHandler : public HttpResourceHandler {
+public:
+    std::shared_ptr<BodyConsumer> consumeBody(const HttpRequest& req) override {
+        (void)req;
+        return std::make_shared<LogConsumer>(aborts);
+    }
+
+    std::atomic<int> aborts{0};
+};
+
+// Pauses on the first piece of an upload and never resumes
+class StalledConsumer : public BodyConsumer {
+public:
+    explicit StalledConsumer(std::atomic<int>& aborts) : m_aborts(aborts) {
+    }
+
+    bool onData(std::string_view data) override {
+        (void)data;
+        return false;
+    }
+    std::shared_ptr<HttpResponse> onEnd(const HttpRequest& req) override {
+        (void)req;
+        return std::make_shared<HttpResponse>(201);
+    }
+    void onAbort() override {
+        ++m_aborts;
+    }
+
+private:
+    std::atomic<int>& m_aborts;
+};
+
+class StalledUploadHandler : public HttpResourceHandler {
+public:
+    std::shared_ptr<BodyConsumer> consumeBody(const HttpRequest& req) override {
+        (void)req;
+        return std::make_shared<StalledConsumer>(aborts);
+    }
+
+    std::atomic<int> aborts{0};
+};
+
 class BaseClass : public ::testing::Test {
 public:
-    BaseClass() : mockHandler(std::make_shared<MockResourceHandler>()) {
+    BaseClass()
+        : mockHandler(std::make_shared<MockResourceHandler>()),
+          countingHandler(std::make_shared<CountingResourceHandler>()),
+          cachedResource(std::make_shared<HttpResource>(countingHandler, "/cached")) {
+        ResponseCache::Config config;
+        config.ttl = std::chrono::seconds(60);
+        cachedResource->enableCache(config);
     }
 
 protected:
     std::shared_ptr<MockResourceHandler> mockHandler;
+    std::shared_ptr<CountingResourceHandler> countingHandler;
+    std::shared_ptr<HttpResource> cachedResource;
 };
 
 // Test fixture for Webserver tests
@@ -96,6 +325,8 @@ protected:
                         .setBufferSize(1024)
                         .setResource("/test", mockHandler)
                         .setResource("/test/{id}", mockHandler)
+                        .setCannedResponse("/health", HttpResponse(200, "healthy"))
+                        .setResource(cachedResource)
                         .build()) {
         nextAvailablePort += 2;  // Increment for the next test
     }
@@ -174,8 +405,8 @@ protected:
             body_stream << response.rdbuf();
             std::string response_body = body_stream.str();
 
-            return http_version + " " + std::to_string(status_code) + " " +
-                   status_message + "\n" + headers + "\r\n" + response_body;
+            return removeDateHeader(http_version + " " + std::to_string(status_code) + " " +
+                                    status_message + "\n" + headers + "\r\n" + response_body);
 
         } catch (std::exception& e) {
             std::cerr << "Exception: " << e.what() << std::endl;
@@ -185,6 +416,33 @@ protected:
         return "";
     }
 
+    // Helper function to read a single response from a persistent connection
+    std::string readHttpResponse(asio::ip::tcp::socket& socket,
+                                 asio::streambuf& buffer) {
+        asio::error_code error;
+        size_t headerLength =
+            asio::read_until(socket, buffer, "\r\n\r\n", error);
+        if (error)
+            return "ERROR: " + error.message();
+        std::string headers(asio::buffers_begin(buffer.data()),
+                            asio::buffers_begin(buffer.data()) + headerLength);
+        buffer.consume(headerLength);
+        size_t bodyLength = 0;
+        size_t pos = headers.find("Content-Length: ");
+        if (pos != std::string::npos)
+            bodyLength = std::stoul(headers.substr(pos + 16));
+        if (buffer.size() < bodyLength)
+            asio::read(socket, buffer,
+                       asio::transfer_exactly(bodyLength - buffer.size()),
+                       error);
+        if (error)
+            return "ERROR: " + error.message();
+        std::string body(asio::buffers_begin(buffer.data()),
+                         asio::buffers_begin(buffer.data()) + bodyLength);
+        buffer.consume(bodyLength);
+        return removeDateHeader(headers + body);
+    }
+
 private:
     static int nextAvailablePort;  // Static member to track the port range
 };
@@ -199,6 +457,16 @@ TEST_F(WebserverTest, TestHttpGet) {
     ASSERT_EQ(response, expectedResponse);
 }
 
+TEST_F(WebserverTest, TestRoutingIgnoresQuery) {
+    std::string expectedResponse =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: "
+        "17\r\n\r\nPUT Response: 123";
+    std::string response = makeHttpRequest("PUT", "/test/123?rate=10&unit=c");
+    ASSERT_EQ(response, expectedResponse);
+    response = makeHttpRequest("GET", "/test?rate=10");
+    ASSERT_NE(response.find("GET Response"), std::string::npos);
+}
+
 TEST_F(WebserverTest, TestHttpPost) {
     std::string expectedResponse =
         "HTTP/1.1 201 Created\r\nContent-Type: text/plain\r\nContent-Length: "
@@ -222,6 +490,47 @@ TEST_F(WebserverTest, TestHttpDelete) {
     ASSERT_EQ(response, expectedResponse);
 }
 
+TEST_F(WebserverTest, TestHttpHeadOmitsBody) {
+    std::string expectedResponse =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: "
+        "12\r\n\r\n";
+    std::string response = makeHttpRequest("HEAD", "/test");
+    ASSERT_EQ(response, expectedResponse);
+}
+
+TEST_F(WebserverTest, TestHttpOptionsListsAllowedMethods) {
+    std::string response = makeHttpRequest("OPTIONS", "/test");
+    EXPECT_EQ(response.rfind("HTTP/1.1 204 No Content\r\n", 0), 0u);
+    EXPECT_NE(response.find("Allow: GET, POST, PUT, DELETE, HEAD, OPTIONS, PATCH\r\n"), std::string::npos);
+}
+
+TEST_F(WebserverTest, TestDisallowedMethod) {
+    auto resource = std::make_shared<HttpResource>(mockHandler, "/readonly");
+    resource->disallowAll();
+    resource->setAllowing(HttpMethod::HTTP_GET, true);
+    resource->setAllowing(HttpMethod::HTTP_HEAD, true);
+    Webserver readOnly = Webserver::Builder().setTcpPort(tcpPort + 1000).setResource(resource).build();
+    readOnly.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), tcpPort + 1000));
+    asio::write(socket, asio::buffer(std::string("POST /readonly HTTP/1.1\r\nContent-Length: 1\r\n\r\nx")));
+    asio::streambuf buffer;
+    std::string response = readHttpResponse(socket, buffer);
+    EXPECT_EQ(response.rfind("HTTP/1.1 405 Method Not Allowed\r\n", 0), 0u);
+    EXPECT_NE(response.find("Allow: GET, HEAD\r\n"), std::string::npos);
+    readOnly.shutdown();
+}
+
+TEST_F(WebserverTest, TestReadBuffersComeFromPool) {
+    for (int i = 0; i < 3; ++i)
+        makeHttpRequest("GET", "/test");
+    BufferPool::Stats stats = webserver.getBufferPoolStats();
+    EXPECT_GE(stats.hits, 3u);
+    EXPECT_EQ(stats.misses, 0u);
+}
+
 TEST_F(WebserverTest, TestHttpGetNotFound) {
     std::string expectedResponse =
         "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: "
@@ -230,4 +539,727 @@ TEST_F(WebserverTest, TestHttpGetNotFound) {
     ASSERT_EQ(response, expectedResponse);
 }
 
+TEST_F(WebserverTest, TestCannedResponse) {
+    std::string expectedResponse =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: "
+        "7\r\n\r\nhealthy";
+    ASSERT_EQ(makeHttpRequest("GET", "/health"), expectedResponse);
+    ASSERT_EQ(makeHttpRequest("GET", "/health"), expectedResponse);
+    ASSERT_EQ(makeHttpRequest("HEAD", "/health"),
+              "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 7\r\n\r\n");
+    EXPECT_EQ(makeHttpRequest("POST", "/health").rfind("HTTP/1.1 405 Method Not Allowed\r\n", 0), 0u);
+    // The canned answer wasn't changed by HEAD
+    ASSERT_EQ(makeHttpRequest("GET", "/health"), expectedResponse);
+}
+
+TEST_F(WebserverTest, TestCachedResource) {
+    ASSERT_NE(makeHttpRequest("GET", "/cached").find("version 1"), std::string::npos);
+    ASSERT_NE(makeHttpRequest("GET", "/cached").find("version 1"), std::string::npos);
+    ASSERT_EQ(makeHttpRequest("HEAD", "/cached").find("version"), std::string::npos);
+    EXPECT_EQ(countingHandler->renders, 1);
+
+    std::string etag = ResponseCache::makeETag("version 1");
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(tcpPort)));
+    std::string request = "GET /cached HTTP/1.1\r\nIf-None-Match: " + etag + "\r\nConnection: close\r\n\r\n";
+    asio::write(socket, asio::buffer(request));
+    asio::streambuf buffer;
+    asio::error_code error;
+    asio::read(socket, buffer, error);
+    std::string response(asio::buffers_begin(buffer.data()), asio::buffers_end(buffer.data()));
+    EXPECT_EQ(removeDateHeader(response),
+              "HTTP/1.1 304 Not Modified\r\nContent-Type: text/plain\r\nETag: " + etag + "\r\n\r\n");
+    EXPECT_EQ(countingHandler->renders, 1);
+
+    // A successful unsafe method drops the cached answer
+    EXPECT_EQ(makeHttpRequest("PUT", "/cached").rfind("HTTP/1.1 204", 0), 0u);
+    EXPECT_NE(makeHttpRequest("GET", "/cached").find("version 2"), std::string::npos);
+    cachedResource->getCache()->invalidate();
+    EXPECT_NE(makeHttpRequest("GET", "/cached").find("version 3"), std::string::npos);
+}
+
+TEST_F(WebserverTest, TestResponsesCarryDate) {
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(tcpPort)));
+    std::string request = "GET /test HTTP/1.1\r\nConnection: close\r\n\r\n";
+    asio::write(socket, asio::buffer(request));
+    asio::streambuf buffer;
+    asio::error_code error;
+    asio::read(socket, buffer, error);
+    std::string response(asio::buffers_begin(buffer.data()), asio::buffers_end(buffer.data()));
+    size_t date = response.find("\r\nDate: ");
+    ASSERT_NE(date, std::string::npos);
+    EXPECT_EQ(response.substr(date + 8, 29).size(), 29u);
+    EXPECT_EQ(response.substr(date + 8 + 25, 6), " GMT\r\n");
+}
+
+TEST_F(WebserverTest, TestUdpRequest) {
+    asio::io_context io_context;
+    asio::ip::udp::socket socket(io_context, asio::ip::udp::v4());
+    asio::ip::udp::endpoint server(asio::ip::address_v4::loopback(), udpPort);
+    std::string request = "GET /test HTTP/1.1\r\n\r\n";
+    socket.send_to(asio::buffer(request), server);
+
+    std::array<char, 1024> buffer;
+    asio::ip::udp::endpoint sender;
+    size_t length = socket.receive_from(asio::buffer(buffer), sender);
+    ASSERT_EQ(removeDateHeader(std::string(buffer.data(), length)),
+              "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+              "Content-Length: 12\r\n\r\nGET Response");
+}
+
+TEST_F(WebserverTest, TestConcurrentUdpSendersGetOwnResponses) {
+    int port = udpPort + 1000;
+    Webserver udpServer = Webserver::Builder()
+                              .setTcpPort(tcpPort + 1000)
+                              .setUdpPort(port)
+                              .setUdpOn()
+                              .setThreadCount(2)
+                              .setUdpSocketCount(2)
+                              .setUdpReceiveDepth(4)
+                              .setResource("/test/{id}", mockHandler)
+                              .build();
+    udpServer.start();
+
+    asio::io_context io_context;
+    asio::ip::udp::endpoint server(asio::ip::address_v4::loopback(), port);
+    std::vector<std::unique_ptr<asio::ip::udp::socket>> clients;
+    for (int i = 0; i < 6; ++i) {
+        clients.push_back(std::make_unique<asio::ip::udp::socket>(io_context, asio::ip::udp::v4()));
+        std::string request = "PUT /test/" + std::to_string(i) + " HTTP/1.1\r\n\r\n";
+        clients.back()->send_to(asio::buffer(request), server);
+    }
+    // Every client has to get the answer to its own request
+    for (int i = 0; i < 6; ++i) {
+        std::array<char, 1024> buffer;
+        asio::ip::udp::endpoint sender;
+        size_t length = clients[i]->receive_from(asio::buffer(buffer), sender);
+        std::string response(buffer.data(), length);
+        EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), "PUT Response: " + std::to_string(i));
+    }
+    udpServer.shutdown();
+}
+
+#ifdef __linux__
+TEST_F(WebserverTest, TestBatchedUdpRequests) {
+    int port = udpPort + 1000;
+    Webserver batched = Webserver::Builder()
+                            .setTcpPort(tcpPort + 1000)
+                            .setUdpPort(port)
+                            .setUdpOn()
+                            .setUdpBatchSize(8)
+                            .setResource("/test/{id}", mockHandler)
+                            .build();
+
+    asio::io_context io_context;
+    asio::ip::udp::socket socket(io_context, asio::ip::udp::v4());
+    asio::ip::udp::endpoint server(asio::ip::address_v4::loopback(), port);
+    // Datagrams queue up in the socket before the server starts reading
+    for (int i = 0; i < 5; ++i) {
+        std::string request =
+            "PUT /test/" + std::to_string(i) + " HTTP/1.1\r\n\r\n";
+        socket.send_to(asio::buffer(request), server);
+    }
+    batched.start();
+
+    std::set<std::string> bodies;
+    for (int i = 0; i < 5; ++i) {
+        std::array<char, 1024> buffer;
+        asio::ip::udp::endpoint sender;
+        size_t length = socket.receive_from(asio::buffer(buffer), sender);
+        std::string response(buffer.data(), length);
+        bodies.insert(response.substr(response.find("\r\n\r\n") + 4));
+    }
+    EXPECT_EQ(bodies.size(), 5u);
+    EXPECT_EQ(bodies.count("PUT Response: 3"), 1u);
+
+    UdpBatchStats stats = batched.getUdpBatchStats();
+    EXPECT_EQ(stats.datagrams, 5u);
+    EXPECT_EQ(stats.fillHistogram.size(), 9u);
+    EXPECT_EQ(stats.fillHistogram[5], 1u);
+    batched.shutdown();
+}
+#endif
+
+TEST_F(WebserverTest, TestKeepAliveServesSeveralRequests) {
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket,
+                  resolver.resolve("localhost", std::to_string(tcpPort)));
+    asio::streambuf buffer;
+    for (int i = 0; i < 3; ++i) {
+        std::string request = "GET /test HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        asio::write(socket, asio::buffer(request));
+        std::string response = readHttpResponse(socket, buffer);
+        ASSERT_EQ(response,
+                  "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+                  "Content-Length: 12\r\n\r\nGET Response");
+    }
+}
+
+TEST_F(WebserverTest, TestPipelinedRequestsAnsweredInOrder) {
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket,
+                  resolver.resolve("localhost", std::to_string(tcpPort)));
+    std::string requests =
+        "GET /test HTTP/1.1\r\n\r\n"
+        "PUT /test/7 HTTP/1.1\r\n\r\n"
+        "PUT /test/8 HTTP/1.1\r\nContent-Length: 0\r\n\r\n";
+    asio::write(socket, asio::buffer(requests));
+    // Client may stop sending while the responses are still on the way
+    socket.shutdown(asio::ip::tcp::socket::shutdown_send);
+
+    asio::streambuf buffer;
+    EXPECT_NE(readHttpResponse(socket, buffer).find("GET Response"),
+              std::string::npos);
+    EXPECT_NE(readHttpResponse(socket, buffer).find("PUT Response: 7"),
+              std::string::npos);
+    EXPECT_NE(readHttpResponse(socket, buffer).find("PUT Response: 8"),
+              std::string::npos);
+    asio::error_code error;
+    asio::read(socket, buffer, asio::transfer_at_least(1), error);
+    EXPECT_EQ(error, asio::error::eof);
+}
+
+TEST_F(WebserverTest, TestRequestLargerThanBuffer) {
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket,
+                  resolver.resolve("localhost", std::to_string(tcpPort)));
+    std::string body(4000, 'x');
+    std::string head = "POST /test HTTP/1.1\r\nHost: localhost\r\n"
+                       "Content-Length: " +
+                       std::to_string(body.size()) + "\r\n\r\n";
+    // Send the request in pieces to emulate a slow link
+    asio::write(socket, asio::buffer(head));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    asio::write(socket, asio::buffer(body.data(), 1500));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    asio::write(socket, asio::buffer(body.data() + 1500, body.size() - 1500));
+
+    asio::streambuf buffer;
+    std::string response = readHttpResponse(socket, buffer);
+    EXPECT_NE(response.find("HTTP/1.1 201 Created"), std::string::npos);
+    EXPECT_NE(response.find("POST Response: " + body), std::string::npos);
+}
+
+TEST_F(WebserverTest, TestConnectionClosedAfterMaxRequests) {
+    int port = tcpPort + 1000;
+    Webserver limited = Webserver::Builder()
+                            .setTcpPort(port)
+                            .setMaxRequestsPerConnection(2)
+                            .setResource("/test", mockHandler)
+                            .build();
+    limited.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    asio::streambuf buffer;
+    std::string request = "GET /test HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    asio::write(socket, asio::buffer(request));
+    std::string first = readHttpResponse(socket, buffer);
+    EXPECT_EQ(first.find("Connection: close"), std::string::npos);
+
+    asio::write(socket, asio::buffer(request));
+    std::string second = readHttpResponse(socket, buffer);
+    EXPECT_NE(second.find("Connection: close"), std::string::npos);
+
+    asio::error_code error;
+    asio::read(socket, buffer, asio::transfer_at_least(1), error);
+    EXPECT_EQ(error, asio::error::eof);
+    limited.shutdown();
+}
+
+TEST_F(WebserverTest, TestCompressedResponses) {
+    int port = tcpPort + 1000;
+    std::string body;
+    for (int i = 0; i < 200; ++i)
+        body += "reading " + std::to_string(i % 10) + "\n";
+    CompressionConfig fastest;
+    fastest.level = 1;
+    auto resource = std::make_shared<HttpResource>(
+        std::make_shared<CannedResponseHandler>(HttpResponse(200, body)), "/fast");
+    resource->setCompression(fastest);
+    Webserver compressing = Webserver::Builder()
+                                .setTcpPort(port)
+                                .setCompression(CompressionConfig())
+                                .setCannedResponse("/export", HttpResponse(200, body))
+                                .setResource(resource)
+                                .build();
+    compressing.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    asio::streambuf buffer;
+    std::string gzipRequest = "GET /export HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: gzip, deflate\r\n\r\n";
+
+    asio::write(socket, asio::buffer(gzipRequest));
+    std::string first = readHttpResponse(socket, buffer);
+    EXPECT_NE(first.find("Content-Encoding: gzip\r\n"), std::string::npos);
+    EXPECT_NE(first.find("Vary: Accept-Encoding\r\n"), std::string::npos);
+    asio::write(socket, asio::buffer(gzipRequest));
+    EXPECT_EQ(readHttpResponse(socket, buffer), first);
+
+    std::string plainRequest = "GET /export HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    asio::write(socket, asio::buffer(plainRequest));
+    std::string plain = readHttpResponse(socket, buffer);
+    EXPECT_EQ(plain.find("Content-Encoding"), std::string::npos);
+    EXPECT_NE(plain.find(body), std::string::npos);
+
+    std::string fastRequest = "GET /fast HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: deflate\r\n\r\n";
+    asio::write(socket, asio::buffer(fastRequest));
+    EXPECT_NE(readHttpResponse(socket, buffer).find("Content-Encoding: deflate\r\n"), std::string::npos);
+
+    // Every canned body was compressed once
+    CompressionStats stats = compressing.getCompressionStats();
+    EXPECT_EQ(stats.compressions, 2u);
+    EXPECT_EQ(stats.responses, 3u);
+    EXPECT_LT(stats.bytesOut, stats.bytesIn);
+    compressing.shutdown();
+}
+
+TEST_F(WebserverTest, TestStaticDirectory) {
+    int port = tcpPort + 1000;
+    auto directory = std::filesystem::temp_directory_path() / "ioteye_webserver_static";
+    std::filesystem::create_directories(directory / "css");
+    std::ofstream(directory / "index.html") << "<h1>ui</h1>";
+    std::ofstream(directory / "css" / "main.css") << "body{}";
+    Webserver assets = Webserver::Builder()
+                           .setTcpPort(port)
+                           .setStaticDirectory("/ui/", directory.string())
+                           .setResource("/test", mockHandler)
+                           .build();
+    assets.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    asio::streambuf buffer;
+    auto get = [&](const std::string& target, const std::string& method = "GET") {
+        std::string request = method + " " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        asio::write(socket, asio::buffer(request));
+        return readHttpResponse(socket, buffer);
+    };
+
+    std::string css = get("/ui/css/main.css");
+    EXPECT_EQ(css.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(css.find("Content-Type: text/css; charset=utf-8\r\n"), std::string::npos);
+    EXPECT_NE(css.find("Last-Modified: "), std::string::npos);
+    EXPECT_NE(css.find("\r\n\r\nbody{}"), std::string::npos);
+    EXPECT_NE(get("/ui").find("<h1>ui</h1>"), std::string::npos);
+    EXPECT_NE(get("/ui/").find("<h1>ui</h1>"), std::string::npos);
+    EXPECT_EQ(get("/ui/missing.js").rfind("HTTP/1.1 404", 0), 0u);
+    EXPECT_EQ(get("/ui/%2e%2e/secret").rfind("HTTP/1.1 404", 0), 0u);
+    EXPECT_EQ(get("/ui/index.html", "POST").rfind("HTTP/1.1 405", 0), 0u);
+    EXPECT_NE(get("/test").find("GET Response"), std::string::npos);
+
+    std::string request = "HEAD /ui/index.html HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    asio::write(socket, asio::buffer(request));
+    asio::error_code error;
+    asio::read(socket, buffer, error);
+    std::string head(asio::buffers_begin(buffer.data()), asio::buffers_end(buffer.data()));
+    EXPECT_NE(head.find("Content-Length: 11\r\n"), std::string::npos);
+    EXPECT_EQ(head.find("<h1>"), std::string::npos);
+    assets.shutdown();
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(WebserverTest, TestRangeRequests) {
+    int port = tcpPort + 1000;
+    auto directory = std::filesystem::temp_directory_path() / "ioteye_webserver_ranges";
+    std::filesystem::create_directories(directory);
+    std::string image;
+    for (int i = 0; i < 300 * 1024; ++i)
+        image += static_cast<char>(i * 7 % 251);
+    std::ofstream(directory / "firmware.bin", std::ios::binary) << image;
+    StaticFileHandler::Config config;
+    config.maxCachedFileSize = 1024;
+    Webserver ota = Webserver::Builder()
+                        .setTcpPort(port)
+                        .setMaxInFlightBytes(16 * 1024)
+                        .setStaticDirectory("/ota", directory.string(), config)
+                        .build();
+    ota.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    asio::streambuf buffer;
+    auto get = [&](const std::string& headers) {
+        std::string request = "GET /ota/firmware.bin HTTP/1.1\r\nHost: localhost\r\n" + headers + "\r\n";
+        asio::write(socket, asio::buffer(request));
+        return readHttpResponse(socket, buffer);
+    };
+
+    std::string whole = get("");
+    EXPECT_EQ(whole.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(whole.find("Accept-Ranges: bytes\r\n"), std::string::npos);
+    EXPECT_EQ(whole.substr(whole.find("\r\n\r\n") + 4), image);
+    size_t etagStart = whole.find("ETag: ") + 6;
+    std::string etag = whole.substr(etagStart, whole.find("\r\n", etagStart) - etagStart);
+
+    // Resuming an interrupted download, pipelined behind a second request
+    std::string pipelined = "GET /ota/firmware.bin HTTP/1.1\r\nRange: bytes=100000-\r\nIf-Range: " + etag +
+                            "\r\n\r\nGET /ota/firmware.bin HTTP/1.1\r\nRange: bytes=-10\r\n\r\n";
+    asio::write(socket, asio::buffer(pipelined));
+    std::string rest = readHttpResponse(socket, buffer);
+    EXPECT_EQ(rest.rfind("HTTP/1.1 206 Partial Content\r\n", 0), 0u);
+    EXPECT_NE(rest.find("Content-Range: bytes 100000-307199/307200\r\n"), std::string::npos);
+    EXPECT_EQ(rest.substr(rest.find("\r\n\r\n") + 4), image.substr(100000));
+    std::string tail = readHttpResponse(socket, buffer);
+    EXPECT_NE(tail.find("Content-Range: bytes 307190-307199/307200\r\n"), std::string::npos);
+    EXPECT_EQ(tail.substr(tail.find("\r\n\r\n") + 4), image.substr(image.size() - 10));
+
+    // The file changed since the client's copy, it gets the whole file again
+    std::string changed = get("Range: bytes=100000-\r\nIf-Range: \"0-0\"\r\n");
+    EXPECT_EQ(changed.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_EQ(changed.substr(changed.find("\r\n\r\n") + 4), image);
+    std::string unsatisfiable = get("Range: bytes=400000-\r\n");
+    EXPECT_EQ(unsatisfiable.rfind("HTTP/1.1 416", 0), 0u);
+    EXPECT_NE(unsatisfiable.find("Content-Range: bytes */307200\r\n"), std::string::npos);
+    ota.shutdown();
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(WebserverTest, TestChunkedResponse) {
+    int port = tcpPort + 1000;
+    Webserver exporter = Webserver::Builder()
+                             .setTcpPort(port)
+                             .setResource("/export", std::make_shared<ExportResourceHandler>())
+                             .setResource("/test", mockHandler)
+                             .build();
+    exporter.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    std::string requests = "GET /export HTTP/1.1\r\nHost: localhost\r\n\r\nGET /test HTTP/1.1\r\n\r\n";
+    asio::write(socket, asio::buffer(requests));
+    asio::streambuf buffer;
+    size_t headLength = asio::read_until(socket, buffer, "\r\n\r\n");
+    std::string head(asio::buffers_begin(buffer.data()), asio::buffers_begin(buffer.data()) + headLength);
+    buffer.consume(headLength);
+    EXPECT_EQ(head.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(head.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+    EXPECT_EQ(head.find("Content-Length"), std::string::npos);
+
+    std::string body;
+    size_t chunks = 0;
+    while (true) {
+        size_t lineLength = asio::read_until(socket, buffer, "\r\n");
+        std::string line(asio::buffers_begin(buffer.data()), asio::buffers_begin(buffer.data()) + lineLength);
+        buffer.consume(lineLength);
+        size_t size = std::stoul(line, nullptr, 16);
+        if (buffer.size() < size + 2)
+            asio::read(socket, buffer, asio::transfer_exactly(size + 2 - buffer.size()));
+        std::string data(asio::buffers_begin(buffer.data()), asio::buffers_begin(buffer.data()) + size + 2);
+        buffer.consume(size + 2);
+        ASSERT_EQ(data.substr(size), "\r\n");
+        if (size == 0)
+            break;
+        body += data.substr(0, size);
+        ++chunks;
+    }
+    EXPECT_EQ(chunks, 50u);
+    EXPECT_EQ(body, ExportResourceHandler::expectedBody());
+    // The pipelined request is answered after the last chunk
+    EXPECT_NE(readHttpResponse(socket, buffer).find("GET Response"), std::string::npos);
+
+    // HTTP/1.0 clients don't know chunked encoding and get the length instead
+    asio::ip::tcp::socket oldClient(io_context);
+    asio::connect(oldClient, resolver.resolve("localhost", std::to_string(port)));
+    asio::write(oldClient, asio::buffer(std::string("GET /export HTTP/1.0\r\n\r\n")));
+    asio::streambuf oldBuffer;
+    std::string response = readHttpResponse(oldClient, oldBuffer);
+    EXPECT_NE(response.find("Content-Length: " + std::to_string(ExportResourceHandler::expectedBody().size())),
+              std::string::npos);
+    EXPECT_EQ(response.find("Transfer-Encoding"), std::string::npos);
+    EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), ExportResourceHandler::expectedBody());
+    exporter.shutdown();
+}
+
+TEST_F(WebserverTest, TestStreamingRequestBody) {
+    int port = tcpPort + 1000;
+    auto logHandler = std::make_shared<LogUploadHandler>();
+    auto logResource = std::make_shared<HttpResource>(logHandler, "/logs/{device}");
+    logResource->disallowAll();
+    logResource->setAllowing(HttpMethod::HTTP_POST, true);
+    // Uploads are far larger than the body limit, they are never held in memory
+    Webserver collector =
+        Webserver::Builder().setTcpPort(port).setMaxBodySize(1024).setResource(logResource).build();
+    collector.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::ip::tcp::socket socket(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    std::string upload = "POST /logs/sensor-7 HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    size_t lines = 0;
+    for (int i = 0; i < 200; ++i) {
+        std::string chunk;
+        for (int j = 0; j < 10; ++j, ++lines)
+            chunk += "t=" + std::to_string(i * 10 + j) + " temperature=21.5\n";
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+        upload += size + chunk + "\r\n";
+    }
+    upload += "0\r\n\r\nPOST /logs/sensor-8 HTTP/1.1\r\nContent-Length: 6\r\n\r\nboot\r\n";
+    size_t bodySize = 0;
+    for (size_t pos = upload.find("t="); pos != std::string::npos; pos = upload.find("t=", pos + 1))
+        bodySize += upload.find('\n', pos) + 1 - pos;
+    asio::write(socket, asio::buffer(upload));
+    asio::streambuf buffer;
+    std::string response = readHttpResponse(socket, buffer);
+    EXPECT_EQ(response.rfind("HTTP/1.1 201 Created\r\n", 0), 0u) << response;
+    EXPECT_NE(response.find("\r\n\r\nsensor-7: " + std::to_string(lines) + " lines, " + std::to_string(bodySize) +
+                            " bytes"),
+              std::string::npos);
+    EXPECT_EQ(response.find("read while paused"), std::string::npos);
+    EXPECT_NE(readHttpResponse(socket, buffer).find("sensor-8: 1 lines, 6 bytes"), std::string::npos);
+
+    // Consumer learns about an upload which never completes
+    asio::ip::tcp::socket aborted(io_context);
+    asio::connect(aborted, resolver.resolve("localhost", std::to_string(port)));
+    asio::write(aborted, asio::buffer(std::string(
+                             "POST /logs/sensor-9 HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nboot\n\r\n")));
+    aborted.close();
+    for (int i = 0; i < 100 && logHandler->aborts == 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(logHandler->aborts, 1);
+    collector.shutdown();
+}
+
+TEST_F(WebserverTest, TestEmptyBodyOnKeepAlive) {
+    int port = tcpPort + 1000;
+    Webserver empty = Webserver::Builder()
+                          .setTcpPort(port)
+                          .setResource("/empty", std::make_shared<EmptyResourceHandler>())
+                          .build();
+    empty.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    asio::streambuf buffer;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < 2; ++i) {
+        asio::write(socket, asio::buffer(std::string("GET /empty HTTP/1.1\r\nHost: localhost\r\n\r\n")));
+        // Without a length the client would wait for the body until the connection is closed
+        asio::read_until(socket, buffer, "\r\n\r\n");
+        std::string head(asio::buffers_begin(buffer.data()), asio::buffers_end(buffer.data()));
+        buffer.consume(buffer.size());
+        EXPECT_EQ(head.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+        EXPECT_NE(head.find("Content-Length: 0\r\n"), std::string::npos);
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(300));
+    empty.shutdown();
+}
+
+TEST_F(WebserverTest, TestSlowHandlerDoesNotBlockOtherConnections) {
+    int port = tcpPort + 1000;
+    Webserver threaded =
+        Webserver::Builder()
+            .setTcpPort(port)
+            .setThreadCount(2)
+            .setResource("/test", mockHandler)
+            .setResource("/slow", std::make_shared<SlowResourceHandler>())
+            .build();
+    threaded.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::resolver resolver(io_context);
+    auto endpoints = resolver.resolve("localhost", std::to_string(port));
+    asio::ip::tcp::socket slowSocket(io_context);
+    asio::ip::tcp::socket fastSocket(io_context);
+    asio::connect(slowSocket, endpoints);
+    asio::connect(fastSocket, endpoints);
+
+    asio::write(slowSocket,
+                asio::buffer(std::string("GET /slow HTTP/1.1\r\n\r\n")));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto started = std::chrono::steady_clock::now();
+    asio::write(fastSocket,
+                asio::buffer(std::string("GET /test HTTP/1.1\r\n\r\n")));
+    asio::streambuf fastBuffer;
+    std::string fastResponse = readHttpResponse(fastSocket, fastBuffer);
+    EXPECT_LT(std::chrono::steady_clock::now() - started,
+              std::chrono::milliseconds(300));
+    EXPECT_NE(fastResponse.find("GET Response"), std::string::npos);
+
+    asio::streambuf slowBuffer;
+    std::string slowResponse = readHttpResponse(slowSocket, slowBuffer);
+    EXPECT_NE(slowResponse.find("Slow Response"), std::string::npos);
+    threaded.shutdown();
+}
+
+TEST_F(WebserverTest, TestShardedServerHandlesRequests) {
+    int port = tcpPort + 1000;
+    Webserver sharded = Webserver::Builder()
+                            .setTcpPort(port)
+                            .setShardCount(2)
+                            .setResource("/test", mockHandler)
+                            .build();
+    sharded.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::resolver resolver(io_context);
+    auto endpoints = resolver.resolve("localhost", std::to_string(port));
+    for (int i = 0; i < 4; ++i) {
+        asio::ip::tcp::socket socket(io_context);
+        asio::connect(socket, endpoints);
+        asio::write(socket,
+                    asio::buffer(std::string("GET /test HTTP/1.1\r\n\r\n")));
+        asio::streambuf buffer;
+        std::string response = readHttpResponse(socket, buffer);
+        EXPECT_NE(response.find("GET Response"), std::string::npos);
+    }
+    sharded.shutdown();
+}
+
+TEST_F(WebserverTest, TestIdleConnectionIsClosed) {
+    int port = tcpPort + 1000;
+    Webserver idle = Webserver::Builder()
+                         .setTcpPort(port)
+                         .setIdleTimeout(std::chrono::milliseconds(100))
+                         .setResource("/test", mockHandler)
+                         .build();
+    idle.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+
+    auto started = std::chrono::steady_clock::now();
+    asio::streambuf buffer;
+    asio::error_code error;
+    asio::read(socket, buffer, asio::transfer_at_least(1), error);
+    EXPECT_EQ(error, asio::error::eof);
+    EXPECT_LT(std::chrono::steady_clock::now() - started,
+              std::chrono::seconds(5));
+    idle.shutdown();
+}
+
+TEST_F(WebserverTest, TestPausedUploadTimesOut) {
+    int port = tcpPort + 1000;
+    auto stalledHandler = std::make_shared<StalledUploadHandler>();
+    Webserver idle = Webserver::Builder()
+                         .setTcpPort(port)
+                         .setIdleTimeout(std::chrono::milliseconds(100))
+                         .setResource("/upload", stalledHandler)
+                         .build();
+    idle.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::socket socket(io_context);
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    asio::write(socket, asio::buffer(std::string("POST /upload HTTP/1.1\r\nContent-Length: 10\r\n\r\nboot")));
+
+    asio::streambuf buffer;
+    asio::error_code error;
+    asio::read(socket, buffer, asio::transfer_at_least(1), error);
+    EXPECT_EQ(error, asio::error::eof);
+    for (int i = 0; i < 100 && stalledHandler->aborts == 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(stalledHandler->aborts, 1);
+    idle.shutdown();
+}
+
+TEST_F(WebserverTest, TestGeneratorWaitsForNotifier) {
+    int port = tcpPort + 1000;
+    auto feedHandler = std::make_shared<FeedResourceHandler>(10);
+    auto stalledHandler = std::make_shared<FeedResourceHandler>(0);
+    Webserver feeds = Webserver::Builder()
+                          .setTcpPort(port)
+                          .setIdleTimeout(std::chrono::milliseconds(100))
+                          .setResource("/feed", feedHandler)
+                          .setResource("/stalled", stalledHandler)
+                          .build();
+    feeds.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::ip::tcp::socket socket(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    asio::write(socket, asio::buffer(std::string("GET /feed HTTP/1.1\r\n\r\n")));
+    asio::streambuf buffer;
+    asio::read_until(socket, buffer, "\r\n0\r\n\r\n");
+    std::string response(asio::buffers_begin(buffer.data()), asio::buffers_end(buffer.data()));
+    EXPECT_NE(response.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+    EXPECT_NE(response.find("9,21.5\n"), std::string::npos);
+    // The generator is asked again only when a reading is ready, not in a loop
+    EXPECT_LE(feedHandler->calls, 21);
+
+    // A generator whose notifier never fires is closed like any idle connection
+    asio::ip::tcp::socket stalled(io_context);
+    asio::connect(stalled, resolver.resolve("localhost", std::to_string(port)));
+    asio::write(stalled, asio::buffer(std::string("GET /stalled HTTP/1.1\r\n\r\n")));
+    asio::streambuf stalledBuffer;
+    asio::error_code error;
+    asio::read(stalled, stalledBuffer, asio::transfer_all(), error);
+    EXPECT_EQ(error, asio::error::eof);
+    EXPECT_EQ(stalledHandler->calls, 1);
+    feeds.shutdown();
+}
+
+TEST_F(WebserverTest, TestSharedResponseIsNotChanged) {
+    int port = tcpPort + 1000;
+    Webserver shared = Webserver::Builder()
+                           .setTcpPort(port)
+                           .setResource("/firmware", std::make_shared<SharedResponseHandler>())
+                           .build();
+    shared.start();
+
+    asio::io_context io_context;
+    asio::ip::tcp::resolver resolver(io_context);
+    asio::ip::tcp::socket socket(io_context);
+    asio::connect(socket, resolver.resolve("localhost", std::to_string(port)));
+    // Both answers go out in one gathered write, each with its own head
+    std::string request = "GET /firmware HTTP/1.1\r\n\r\n";
+    asio::write(socket, asio::buffer(request + request));
+    asio::streambuf buffer;
+    for (int i = 0; i < 2; ++i) {
+        std::string response = readHttpResponse(socket, buffer);
+        EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << response;
+        EXPECT_NE(response.find("\r\n\r\nfirmware 1.2.0"), std::string::npos);
+    }
+
+    // HEAD drops the body of its own copy, the next GET still gets it
+    asio::write(socket, asio::buffer(std::string("HEAD /firmware HTTP/1.1\r\n\r\n")));
+    asio::read_until(socket, buffer, "\r\n\r\n");
+    std::string head(asio::buffers_begin(buffer.data()), asio::buffers_end(buffer.data()));
+    buffer.consume(buffer.size());
+    EXPECT_NE(head.find("Content-Length: 14\r\n"), std::string::npos);
+    asio::write(socket, asio::buffer(request));
+    EXPECT_NE(readHttpResponse(socket, buffer).find("\r\n\r\nfirmware 1.2.0"), std::string::npos);
+
+    // Connection header added for one client doesn't reach the others
+    asio::ip::tcp::socket oldClient(io_context);
+    asio::connect(oldClient, resolver.resolve("localhost", std::to_string(port)));
+    asio::write(oldClient, asio::buffer(std::string("GET /firmware HTTP/1.0\r\nConnection: keep-alive\r\n\r\n")));
+    asio::streambuf oldBuffer;
+    EXPECT_NE(readHttpResponse(oldClient, oldBuffer).find("Connection: keep-alive\r\n"), std::string::npos);
+    asio::write(socket, asio::buffer(request));
+    EXPECT_EQ(readHttpResponse(socket, buffer).find("Connection:"), std::string::npos);
+    shared.shutdown();
+}
+
 }  // namespace ioteye
\ No newline at end of file